@@ -1,5 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SEARCH_X86 1
+#include <immintrin.h>
+#else
+#define SEARCH_X86 0
+#endif
 
 // Iterative Binary Search
 int binary_search_iterative(int arr[], int left, int right, int target) {
@@ -33,6 +48,1015 @@ int binary_search_recursive(int arr[], int left, int right, int target) {
     return -1; // Element not found
 }
 
+// Keys a batched search advances in lockstep; 8-32 keeps enough cache
+// misses in flight without running out of line fill buffers
+#ifndef SEARCH_BATCH
+#define SEARCH_BATCH 16
+#endif
+
+// Windows at most this wide are finished by a branchless search
+#define INTERPOLATION_CUTOFF 16
+
+// Branchless bound searches. DEFINE_BOUND_SEARCH(name, before) expands to
+//   int name##_branchless(const int arr[], int n, int target);
+//   int name##_eytzinger(const EytzingerIndex *index, int target);
+//   void name##_batch(const int arr[], int n, const int targets[], int count,
+//                     int results[]);
+//   void name##_eytzinger_batch(const EytzingerIndex *index,
+//                               const int targets[], int count, int results[]);
+//   int name##_interpolation(const int arr[], int n, int target);
+//   int name##_window(const int arr[], int n, int target, int lo, int hi);
+// which return the first position i in the sorted array for which
+// before(arr[i], target) is false, or n if there is none. With
+// before = "key < target" that is the lower bound (first key >= target);
+// with "key <= target" the upper bound (first key > target).
+//
+// The branchless version halves a window [base, base + len) with a
+// conditional move instead of a branch, so it never mispredicts, and
+// prefetches both midpoints the next step may probe while the current
+// load is in flight. The Eytzinger version walks the same keys stored in
+// BFS order (see create_eytzinger_index), where the next four levels of a
+// node's subtree are the 16 consecutive keys at index 16 * k, one cache
+// line, prefetched four steps ahead.
+//
+// The batch versions answer targets[0..count-1] into results[] in groups
+// of SEARCH_BATCH. Every search over the same n takes the same number of
+// steps, so a group needs no per-key state machine (as in AMAC): each step
+// advances every key of the group by one level and prefetches the exact
+// line that key probes next, so up to SEARCH_BATCH independent DRAM
+// misses overlap instead of one.
+//
+// Interpolation search probes where the target would sit if the keys
+// between the window ends were evenly spaced, which takes O(log log n)
+// probes on uniform keys. Any step that fails to halve the window is
+// followed by a bisection, so skewed keys still take O(log n). The window
+// version searches arr[lo..hi) given as a hint (e.g. a learned model's
+// error bound) and falls back to the rest of the array if the answer
+// lies outside it.
+typedef struct {
+    int *keys;    // keys[1..n] in BFS order; keys[0] unused, 64-byte aligned
+    int n;
+    int depth;    // floor(log2(n)): level of the deepest, partial row
+} EytzingerIndex;
+
+// Largest n for the Eytzinger layout: the walk index reaches 2n + 1, which
+// must fit an int without becoming all ones
+#define EYTZINGER_MAX_N ((1 << 30) - 2)
+
+int eytzinger_rank(const EytzingerIndex *index, int k);
+
+#define DEFINE_BOUND_SEARCH(name, before)                                      \
+int name##_branchless(const int arr[], int n, int target) {                    \
+    const int *base = arr;                                                     \
+    int len = n;                                                               \
+                                                                               \
+    if (n == 0)                                                                \
+        return 0;                                                              \
+    while (len > 1) {                                                          \
+        int half = len / 2;                                                    \
+        int next_half = (len - half) / 2;                                      \
+        __builtin_prefetch(&base[next_half]);                                  \
+        __builtin_prefetch(&base[half + next_half]);                           \
+        base = before(base[half], target) ? base + half : base;               \
+        len -= half;                                                           \
+    }                                                                          \
+    return (int)(base - arr) + before(*base, target);                          \
+}                                                                              \
+                                                                               \
+int name##_eytzinger(const EytzingerIndex *index, int target) {                \
+    const int *keys = index->keys;                                             \
+    int k = 1;                                                                 \
+                                                                               \
+    while (k <= index->n) {                                                    \
+        __builtin_prefetch(keys + 16 * (size_t)k);                             \
+        k = 2 * k + before(keys[k], target);                                   \
+    }                                                                          \
+    /* Undo the right turns after the last left one: k is the answer node */  \
+    k >>= __builtin_ffs(~k);                                                   \
+    return k ? eytzinger_rank(index, k) : index->n;                            \
+}                                                                              \
+                                                                               \
+void name##_batch(const int arr[], int n, const int targets[], int count,      \
+                  int results[]) {                                             \
+    for (int start = 0; start < count; start += SEARCH_BATCH) {                \
+        const int *t = targets + start;                                        \
+        const int *base[SEARCH_BATCH];                                         \
+        int lanes = count - start;                                             \
+        if (lanes > SEARCH_BATCH)                                              \
+            lanes = SEARCH_BATCH;                                              \
+                                                                               \
+        for (int g = 0; g < lanes; g++)                                        \
+            base[g] = arr;                                                     \
+        for (int len = n; len > 1; ) {                                         \
+            int half = len / 2;                                                \
+            int next_half = (len - half) / 2;                                  \
+            for (int g = 0; g < lanes; g++) {                                  \
+                if (before(base[g][half], t[g]))                               \
+                    base[g] += half;   /* Compiled to a cmov */               \
+                __builtin_prefetch(&base[g][next_half]);                       \
+            }                                                                  \
+            len -= half;                                                       \
+        }                                                                      \
+        for (int g = 0; g < lanes; g++)                                        \
+            results[start + g] = (n == 0) ? 0 :                                \
+                (int)(base[g] - arr) + before(*base[g], t[g]);                 \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name##_eytzinger_batch(const EytzingerIndex *index, const int targets[], \
+                            int count, int results[]) {                        \
+    const int *keys = index->keys;                                             \
+    int n = index->n;                                                          \
+                                                                               \
+    for (int start = 0; start < count; start += SEARCH_BATCH) {                \
+        const int *t = targets + start;                                        \
+        int k[SEARCH_BATCH];                                                   \
+        int lanes = count - start;                                             \
+        if (lanes > SEARCH_BATCH)                                              \
+            lanes = SEARCH_BATCH;                                              \
+                                                                               \
+        for (int g = 0; g < lanes; g++)                                        \
+            k[g] = 1;                                                          \
+        /* Levels above index->depth are full, so every key steps there */    \
+        for (int level = 0; level < index->depth; level++) {                   \
+            for (int g = 0; g < lanes; g++) {                                  \
+                k[g] = 2 * k[g] + before(keys[k[g]], t[g]);                    \
+                __builtin_prefetch(keys + 16 * (size_t)k[g]);                  \
+            }                                                                  \
+        }                                                                      \
+        for (int g = 0; g < lanes; g++) {                                      \
+            int kg = k[g];                                                     \
+            if (kg <= n)                                                       \
+                kg = 2 * kg + before(keys[kg], t[g]);                          \
+            kg >>= __builtin_ffs(~kg);                                         \
+            results[start + g] = kg ? eytzinger_rank(index, kg) : n;           \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+int name##_interpolation(const int arr[], int n, int target) {                 \
+    int lo = 0, hi = n;   /* The answer is in [lo, hi] */                      \
+                                                                               \
+    while (hi - lo > INTERPOLATION_CUTOFF) {                                   \
+        int width = hi - lo;                                                   \
+        if (!before(arr[lo], target))                                          \
+            return lo;                                                         \
+        if (before(arr[hi - 1], target))                                       \
+            return hi;                                                         \
+                                                                               \
+        /* arr[lo] < arr[hi - 1] here, so the fraction is in [0, 1] */        \
+        double fraction = ((double)target - arr[lo]) /                         \
+                          ((double)arr[hi - 1] - arr[lo]);                     \
+        int probe = lo + (int)(fraction * (hi - 1 - lo));                      \
+        if (before(arr[probe], target))                                        \
+            lo = probe + 1;                                                    \
+        else                                                                   \
+            hi = probe;                                                        \
+                                                                               \
+        if (hi - lo > width / 2) {                                             \
+            int mid = lo + (hi - lo) / 2;                                      \
+            if (before(arr[mid], target))                                      \
+                lo = mid + 1;                                                  \
+            else                                                               \
+                hi = mid;                                                      \
+        }                                                                      \
+    }                                                                          \
+    return lo + name##_branchless(arr + lo, hi - lo, target);                  \
+}                                                                              \
+                                                                               \
+int name##_window(const int arr[], int n, int target, int lo, int hi) {        \
+    hi = (hi < 0) ? 0 : (hi > n) ? n : hi;                                     \
+    lo = (lo < 0) ? 0 : (lo > hi) ? hi : lo;                                   \
+    if (lo > 0 && !before(arr[lo - 1], target))                                \
+        return name##_branchless(arr, lo, target);                             \
+    if (hi < n && before(arr[hi], target))                                     \
+        return hi + name##_branchless(arr + hi, n - hi, target);               \
+    return lo + name##_branchless(arr + lo, hi - lo, target);                  \
+}
+
+#define LOWER_BEFORE(key, target) ((key) < (target))
+#define UPPER_BEFORE(key, target) ((key) <= (target))
+
+DEFINE_BOUND_SEARCH(lower_bound, LOWER_BEFORE)
+DEFINE_BOUND_SEARCH(upper_bound, UPPER_BEFORE)
+
+// Stores keys[k] for the subtree rooted at k from the sorted array, in order
+int eytzinger_fill(const int arr[], int i, int keys[], int k, int n) {
+    if (k <= n) {
+        i = eytzinger_fill(arr, i, keys, 2 * k, n);
+        keys[k] = arr[i++];
+        i = eytzinger_fill(arr, i, keys, 2 * k + 1, n);
+    }
+    return i;
+}
+
+// Copy of the sorted arr[0..n-1] in Eytzinger (BFS) order: the children of
+// keys[k] are keys[2k] and keys[2k+1], so a search moves through one array
+// from the top down and the first levels share a few cache lines.
+EytzingerIndex *create_eytzinger_index(const int arr[], int n) {
+    EytzingerIndex *index = malloc(sizeof(EytzingerIndex));
+    size_t bytes = ((size_t)(n + 1) * sizeof(int) + 63) / 64 * 64;
+
+    if (!index || !(index->keys = aligned_alloc(64, bytes))) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    index->n = n;
+    index->depth = 0;
+    while ((2L << index->depth) <= n)
+        index->depth++;
+    index->keys[0] = 0;
+    eytzinger_fill(arr, 0, index->keys, 1, n);
+    return index;
+}
+
+void free_eytzinger_index(EytzingerIndex *index) {
+    free(index->keys);
+    free(index);
+}
+
+// Position in the sorted array of the key at node k, in O(1). Node k at
+// level d would sit at in-order position p in a perfect tree one level
+// deeper than index->depth; the tree only lacks the rightmost nodes of the
+// last level, so subtract those of them that would come before k.
+int eytzinger_rank(const EytzingerIndex *index, int k) {
+    int d = 31 - __builtin_clz(k);
+    int h = index->depth;
+    long p = ((2L * (k - (1L << d)) + 1) << (h - d)) - 1;
+    long last_before = (p + 1) / 2;                 // Last-level slots left of k
+    long last_present = index->n - (1L << h) + 1;   // Filled last-level slots
+    return (int)(p - (last_before > last_present ? last_before - last_present : 0));
+}
+
+// Batched exact-match search: results[q] is an index of targets[q] in the
+// sorted arr[0..n-1], or -1 if absent, like binary_search_iterative
+void binary_search_batch(const int arr[], int n, const int targets[], int count,
+                         int results[]) {
+    lower_bound_batch(arr, n, targets, count, results);
+    for (int q = 0; q < count; q++) {
+        if (results[q] == n || arr[results[q]] != targets[q])
+            results[q] = -1;
+    }
+}
+
+// Static B+ tree (S+ tree) over a sorted array, for read-only lookups.
+// Every node is STREE_B = 16 sorted keys, one 64-byte cache line, with
+// STREE_B + 1 children. Layer 0 is the sorted keys themselves, padded
+// with INT_MAX to whole nodes, so a leaf position is the array position.
+// Key i of an internal node is the smallest key under child i + 1, so the
+// number of node keys below the target is the child to descend into.
+// With AVX2 that count is two compares, two movemasks and a popcount; a
+// search reads one line per layer: 5 lines for 1M keys, 7 for 100M.
+#define STREE_B 16
+#define STREE_MAX_HEIGHT 8   // Layers for INT_MAX keys; 8 from 386,201,105 keys
+
+typedef struct {
+    int *keys;                         // All layers, 64-byte aligned
+    int n;
+    int height;                        // Layers, including the leaves
+    long offset[STREE_MAX_HEIGHT + 1]; // First key of each layer in keys[],
+                                       // then the total key count
+    int avx2;                          // Use the AVX2 node search
+} STreeIndex;
+
+// Keys in the layer above one of `keys` keys: one per child but the first
+long stree_parent_keys(long keys) {
+    long nodes = (keys + STREE_B - 1) / STREE_B;
+    return (nodes + STREE_B) / (STREE_B + 1) * STREE_B;
+}
+
+// Builds the layers bottom-up in O(n): the leaves are a copy of arr, and
+// each internal key is read straight from the leaves at the first position
+// under its child, found by multiplying down the layers.
+STreeIndex *create_stree_index(const int arr[], int n) {
+    STreeIndex *tree = malloc(sizeof(STreeIndex));
+    if (!tree) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    tree->n = n;
+    tree->height = 1;
+    tree->offset[0] = 0;
+    long leaves = (n > 0) ? (n + STREE_B - 1) / STREE_B * STREE_B : STREE_B;
+    long layer_keys = leaves, total = leaves;
+    while (layer_keys > STREE_B) {
+        tree->offset[tree->height++] = total;
+        layer_keys = stree_parent_keys(layer_keys);
+        total += layer_keys;
+    }
+    tree->offset[tree->height] = total;
+
+    tree->keys = aligned_alloc(64, total * sizeof(int));
+    if (!tree->keys) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    memcpy(tree->keys, arr, (size_t)n * sizeof(int));
+    for (long i = n; i < leaves; i++)
+        tree->keys[i] = INT_MAX;
+
+    for (int h = 1; h < tree->height; h++) {
+        for (long i = 0; i < tree->offset[h + 1] - tree->offset[h]; i++) {
+            long node = i / STREE_B, j = i % STREE_B;
+            long child = node * (STREE_B + 1) + j + 1;
+            for (int l = 1; l < h; l++)
+                child *= STREE_B + 1;   // Leftmost descendant in layer 0
+            tree->keys[tree->offset[h] + i] =
+                (child * STREE_B < n) ? tree->keys[child * STREE_B] : INT_MAX;
+        }
+    }
+
+#if SEARCH_X86
+    __builtin_cpu_init();
+    tree->avx2 = __builtin_cpu_supports("avx2");
+#else
+    tree->avx2 = 0;
+#endif
+    return tree;
+}
+
+void free_stree_index(STreeIndex *tree) {
+    free(tree->keys);
+    free(tree);
+}
+
+// Number of the 16 sorted node keys that are below target
+static inline int stree_rank_scalar(const int node[], int target) {
+    int rank = 0;
+    for (int i = 0; i < STREE_B; i++)
+        rank += node[i] < target;
+    return rank;
+}
+
+#if SEARCH_X86
+__attribute__((target("avx2")))
+static inline int stree_rank_avx2(const int node[], int target) {
+    __m256i x = _mm256_set1_epi32(target);
+    __m256i lo = _mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i *)node));
+    __m256i hi = _mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i *)(node + 8)));
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(lo)) |
+               _mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8;
+    return __builtin_popcount(mask);
+}
+#endif
+
+// DEFINE_STREE_SEARCH(isa, target) expands to
+//   int stree_lower_bound_##isa(const STreeIndex *tree, int key);
+// a descent with stree_rank_##isa as the node search
+#define DEFINE_STREE_SEARCH(isa, target)                                       \
+target int stree_lower_bound_##isa(const STreeIndex *tree, int key) {          \
+    long k = 0;   /* First key of the current node in its layer */            \
+                                                                               \
+    for (int h = tree->height - 1; h > 0; h--) {                               \
+        int i = stree_rank_##isa(tree->keys + tree->offset[h] + k, key);       \
+        k = k * (STREE_B + 1) + (long)i * STREE_B;                             \
+    }                                                                          \
+    k += stree_rank_##isa(tree->keys + k, key);                                \
+    return (k < tree->n) ? (int)k : tree->n;                                   \
+}
+
+DEFINE_STREE_SEARCH(scalar, )
+#if SEARCH_X86
+DEFINE_STREE_SEARCH(avx2, __attribute__((target("avx2"))))
+#endif
+
+// Position of the first key >= key, or n if there is none
+int stree_lower_bound(const STreeIndex *tree, int key) {
+#if SEARCH_X86
+    if (tree->avx2)
+        return stree_lower_bound_avx2(tree, key);
+#endif
+    return stree_lower_bound_scalar(tree, key);
+}
+
+// Index of key in the sorted array, or -1 if absent
+int stree_search(const STreeIndex *tree, int key) {
+    int i = stree_lower_bound(tree, key);
+    return (i < tree->n && tree->keys[i] == key) ? i : -1;
+}
+
+// Learned index (PGM-style): a piecewise linear model of position as a
+// function of key. Each segment predicts pos + slope * (key - first key)
+// to within epsilon positions for every distinct key it covers, so a
+// lookup evaluates one segment per level and searches only the window
+// around the prediction. The segments' first keys are indexed the same
+// way, level by level, until LEARNED_TOP_KEYS remain for a plain search.
+// Segments are fitted greedily in O(n) with the shrinking cone: the range
+// of slopes that keeps every key so far within epsilon narrows with each
+// key, and a new segment starts when it would become empty.
+#define LEARNED_EPSILON 32        // Error bound of the segments over the keys
+#define LEARNED_EPSILON_UPPER 4   // Error bound of the upper levels
+#define LEARNED_TOP_KEYS 64       // Segments left for a plain search at the top
+#define LEARNED_MAX_LEVELS 16
+
+typedef struct {
+    int *keys;       // First key of each segment
+    int *pos;        // Its position in the level below
+    double *slope;
+    int count;
+    int capacity;
+} LearnedLevel;
+
+typedef struct {
+    const int *arr;  // The sorted keys; not copied
+    int n;
+    int levels;
+    LearnedLevel level[LEARNED_MAX_LEVELS];   // level[0] models arr
+} LearnedIndex;
+
+void learned_level_push(LearnedLevel *level, int key, int pos) {
+    if (level->count == level->capacity) {
+        level->capacity = level->capacity ? 2 * level->capacity : 64;
+        level->keys = realloc(level->keys, level->capacity * sizeof(int));
+        level->pos = realloc(level->pos, level->capacity * sizeof(int));
+        level->slope = realloc(level->slope, level->capacity * sizeof(double));
+        if (!level->keys || !level->pos || !level->slope) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+    }
+    level->keys[level->count] = key;
+    level->pos[level->count] = pos;
+    level->slope[level->count] = 0.0;
+    level->count++;
+}
+
+// Fits segments to keys[0..n-1]. Runs of equal keys are modelled at
+// their first position, which is their lower bound.
+void learned_fit(const int keys[], int n, int epsilon, LearnedLevel *level) {
+    double slope_lo = 0.0, slope_hi = -1.0;   // slope_hi < 0: no cone yet
+
+    memset(level, 0, sizeof(LearnedLevel));
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && keys[i] == keys[i - 1])
+            continue;
+        if (level->count > 0) {
+            int s = level->count - 1;
+            double dx = (double)keys[i] - level->keys[s];
+            double dy = (double)i - level->pos[s];
+            double lo = (dy - epsilon) / dx, hi = (dy + epsilon) / dx;
+
+            if (slope_hi < 0.0) {
+                slope_lo = (lo > 0.0) ? lo : 0.0;   // Second key opens the cone
+                slope_hi = hi;
+                continue;
+            }
+            if (lo <= slope_hi && hi >= slope_lo) {
+                slope_lo = (lo > slope_lo) ? lo : slope_lo;
+                slope_hi = (hi < slope_hi) ? hi : slope_hi;
+                continue;
+            }
+            level->slope[s] = (slope_lo + slope_hi) / 2;
+        }
+        learned_level_push(level, keys[i], i);
+        slope_lo = 0.0;
+        slope_hi = -1.0;
+    }
+    if (slope_hi >= 0.0)
+        level->slope[level->count - 1] = (slope_lo + slope_hi) / 2;
+}
+
+LearnedIndex *create_learned_index(const int arr[], int n) {
+    LearnedIndex *index = malloc(sizeof(LearnedIndex));
+    if (!index) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    index->arr = arr;
+    index->n = n;
+    learned_fit(arr, n, LEARNED_EPSILON, &index->level[0]);
+    index->levels = 1;
+    while (index->level[index->levels - 1].count > LEARNED_TOP_KEYS &&
+           index->levels < LEARNED_MAX_LEVELS) {
+        LearnedLevel *below = &index->level[index->levels - 1];
+        learned_fit(below->keys, below->count, LEARNED_EPSILON_UPPER,
+                    &index->level[index->levels++]);
+    }
+    return index;
+}
+
+void free_learned_index(LearnedIndex *index) {
+    for (int l = 0; l < index->levels; l++) {
+        free(index->level[l].keys);
+        free(index->level[l].pos);
+        free(index->level[l].slope);
+    }
+    free(index);
+}
+
+// Bytes of model, not counting the keys it indexes
+size_t learned_index_bytes(const LearnedIndex *index) {
+    size_t bytes = sizeof(LearnedIndex);
+    for (int l = 0; l < index->levels; l++)
+        bytes += index->level[l].count * (2 * sizeof(int) + sizeof(double));
+    return bytes;
+}
+
+// Position segment seg predicts for target, kept between its own first
+// position and the next segment's (limit: size of the level below)
+static inline int learned_predict(const LearnedLevel *level, int seg, int target, int limit) {
+    double p = level->pos[seg] + level->slope[seg] * ((double)target - level->keys[seg]);
+    int end = (seg + 1 < level->count) ? level->pos[seg + 1] : limit;
+
+    if (p < level->pos[seg])
+        return level->pos[seg];
+    return (p > end) ? end : (int)p;
+}
+
+// Position of the first key >= target, or n if there is none
+int learned_lower_bound(const LearnedIndex *index, int target) {
+    const LearnedLevel *top = &index->level[index->levels - 1];
+    int seg = upper_bound_branchless(top->keys, top->count, target) - 1;
+
+    // seg is the last segment whose first key is <= target
+    for (int l = index->levels - 1; l > 0 && seg >= 0; l--) {
+        const LearnedLevel *below = &index->level[l - 1];
+        int p = learned_predict(&index->level[l], seg, target, below->count);
+        seg = upper_bound_window(below->keys, below->count, target,
+                                 p - LEARNED_EPSILON_UPPER - 1,
+                                 p + LEARNED_EPSILON_UPPER + 2) - 1;
+    }
+    if (seg < 0)
+        return 0;   // Below the first key
+
+    int p = learned_predict(&index->level[0], seg, target, index->n);
+    return lower_bound_window(index->arr, index->n, target,
+                              p - LEARNED_EPSILON - 1, p + LEARNED_EPSILON + 2);
+}
+
+// Index of target in the sorted array, or -1 if absent
+int learned_search(const LearnedIndex *index, int target) {
+    int i = learned_lower_bound(index, target);
+    return (i < index->n && index->arr[i] == target) ? i : -1;
+}
+
+// Sorted array file: a 64-byte header, then the keys as raw little-endian
+// int32, then optionally the same keys in Eytzinger order (n + 1 slots,
+// slot 0 unused). Sections start on SORTED_FILE_ALIGN boundaries, so they
+// can be mapped with 2 MB pages and the Eytzinger keys are cache line
+// aligned; the gaps are holes and take no disk space. A search service
+// maps the file read-only and searches the page cache directly: opening
+// costs a few system calls whatever the size, and pages are read on
+// first touch.
+#define SORTED_FILE_MAGIC "SORTARR1"
+#define SORTED_FILE_VERSION 1
+#define SORTED_FILE_ALIGN (2L << 20)
+
+#define SORTED_FILE_WILLNEED 1    // Start reading the whole file in the background
+#define SORTED_FILE_HUGEPAGES 2   // Ask for transparent huge pages
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t key_bytes;           // sizeof(int32_t)
+    uint64_t count;
+    uint64_t keys_offset;
+    uint64_t eytzinger_offset;    // 0 if there is no Eytzinger section
+    uint64_t file_bytes;
+    uint64_t reserved[2];
+} SortedFileHeader;
+
+typedef struct {
+    int fd;
+    char *map;
+    size_t length;
+    const int *keys;              // keys[0..n-1], sorted
+    int n;
+    int has_eytzinger;
+    EytzingerIndex eytzinger;     // Points into the mapping when present
+} SortedFile;
+
+static size_t sorted_file_align(size_t bytes) {
+    return (bytes + SORTED_FILE_ALIGN - 1) / SORTED_FILE_ALIGN * SORTED_FILE_ALIGN;
+}
+
+static int little_endian(void) {
+    uint32_t one = 1;
+    return *(const unsigned char *)&one == 1;
+}
+
+// Creates path sized for n keys and maps it writable. The caller stores
+// the sorted keys in file->keys, then calls finish_sorted_file, which
+// writes the Eytzinger section and, last, the header, so a file cut short
+// by a crash is rejected on open. Returns 0, or -1 on an I/O error.
+int begin_sorted_file(const char *path, int n, int with_eytzinger, SortedFile *file) {
+    if (!little_endian()) {
+        fprintf(stderr, "Sorted array files store little-endian keys; this host is big-endian.\n");
+        return -1;
+    }
+    if (n < 0 || (with_eytzinger && n > EYTZINGER_MAX_N)) {
+        fprintf(stderr, "%s: cannot store %d keys with this layout\n", path, n);
+        return -1;
+    }
+    size_t keys_offset = sorted_file_align(sizeof(SortedFileHeader));
+    size_t eytzinger_offset = with_eytzinger ? sorted_file_align(keys_offset + (size_t)n * sizeof(int)) : 0;
+    size_t length = with_eytzinger ? eytzinger_offset + ((size_t)n + 1) * sizeof(int)
+                                   : keys_offset + (size_t)n * sizeof(int);
+
+    memset(file, 0, sizeof(SortedFile));
+    file->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (ftruncate(file->fd, length) < 0) {
+        perror(path);
+        close(file->fd);
+        return -1;
+    }
+    file->map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if (file->map == MAP_FAILED) {
+        perror(path);
+        close(file->fd);
+        return -1;
+    }
+    file->length = length;
+    file->keys = (const int *)(file->map + keys_offset);
+    file->n = n;
+    file->has_eytzinger = with_eytzinger;
+    if (with_eytzinger) {
+        file->eytzinger.keys = (int *)(file->map + eytzinger_offset);
+        file->eytzinger.n = n;
+    }
+    return 0;
+}
+
+int finish_sorted_file(SortedFile *file) {
+    SortedFileHeader header;
+    int status = 0;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SORTED_FILE_MAGIC, sizeof(header.magic));
+    header.version = SORTED_FILE_VERSION;
+    header.key_bytes = sizeof(int32_t);
+    header.count = file->n;
+    header.keys_offset = (const char *)file->keys - file->map;
+    header.file_bytes = file->length;
+    if (file->has_eytzinger) {
+        header.eytzinger_offset = (char *)file->eytzinger.keys - file->map;
+        file->eytzinger.keys[0] = 0;
+        eytzinger_fill(file->keys, 0, file->eytzinger.keys, 1, file->n);
+    }
+
+    // Keys first, header last: the header is only valid over durable data
+    if (msync(file->map, file->length, MS_SYNC) < 0)
+        status = -1;
+    memcpy(file->map, &header, sizeof(header));
+    if (msync(file->map, sizeof(header), MS_SYNC) < 0)
+        status = -1;
+    if (status < 0)
+        perror("msync");
+    munmap(file->map, file->length);
+    close(file->fd);
+    return status;
+}
+
+// Writes the sorted arr[0..n-1], with an Eytzinger section if asked
+int write_sorted_file(const char *path, const int arr[], int n, int with_eytzinger) {
+    SortedFile file;
+    if (begin_sorted_file(path, n, with_eytzinger, &file) < 0)
+        return -1;
+    memcpy((int *)file.keys, arr, (size_t)n * sizeof(int));
+    return finish_sorted_file(&file);
+}
+
+void close_sorted_file(SortedFile *file) {
+    munmap(file->map, file->length);
+    close(file->fd);
+    free(file);
+}
+
+// Maps path read-only and checks its header; the keys themselves are not
+// read. flags combines SORTED_FILE_WILLNEED and SORTED_FILE_HUGEPAGES.
+// Returns NULL after printing the reason if the file is unusable.
+SortedFile *open_sorted_file(const char *path, int flags) {
+    SortedFile *file = malloc(sizeof(SortedFile));
+    struct stat st;
+
+    if (!file) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    memset(file, 0, sizeof(SortedFile));
+    file->fd = open(path, O_RDONLY);
+    if (file->fd < 0 || fstat(file->fd, &st) < 0) {
+        perror(path);
+        if (file->fd >= 0)
+            close(file->fd);
+        free(file);
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(SortedFileHeader) || !little_endian()) {
+        fprintf(stderr, "%s: not a sorted array file for this host\n", path);
+        close(file->fd);
+        free(file);
+        return NULL;
+    }
+    file->length = st.st_size;
+    file->map = mmap(NULL, file->length, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (file->map == MAP_FAILED) {
+        perror(path);
+        close(file->fd);
+        free(file);
+        return NULL;
+    }
+
+    // Every section must lie inside the file and be cache line aligned
+    const SortedFileHeader *header = (const SortedFileHeader *)file->map;
+    uint64_t keys_bytes = header->count * sizeof(int32_t);
+    int valid = memcmp(header->magic, SORTED_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                header->version == SORTED_FILE_VERSION &&
+                header->key_bytes == sizeof(int32_t) && header->count <= INT_MAX &&
+                header->file_bytes == file->length && header->keys_offset % 64 == 0 &&
+                header->keys_offset <= file->length &&
+                keys_bytes <= file->length - header->keys_offset;
+    if (valid && header->eytzinger_offset)
+        valid = header->count <= EYTZINGER_MAX_N && header->eytzinger_offset % 64 == 0 &&
+                header->eytzinger_offset <= file->length &&
+                keys_bytes + sizeof(int32_t) <= file->length - header->eytzinger_offset;
+    if (!valid) {
+        fprintf(stderr, "%s: bad or truncated sorted array file\n", path);
+        close_sorted_file(file);
+        return NULL;
+    }
+
+    file->keys = (const int *)(file->map + header->keys_offset);
+    file->n = (int)header->count;
+    file->has_eytzinger = header->eytzinger_offset != 0;
+    if (file->has_eytzinger) {
+        file->eytzinger.keys = (int *)(file->map + header->eytzinger_offset);
+        file->eytzinger.n = file->n;
+        while ((2L << file->eytzinger.depth) <= file->n)
+            file->eytzinger.depth++;
+    }
+
+    // Searches jump around, so readahead would only waste I/O. The top of
+    // the Eytzinger tree is touched by every lookup: fetch it right away.
+    madvise(file->map, file->length, MADV_RANDOM);
+    if (file->has_eytzinger) {
+        size_t top = ((size_t)file->n + 1) * sizeof(int);
+        madvise((char *)file->eytzinger.keys, top < SORTED_FILE_ALIGN ? top : SORTED_FILE_ALIGN,
+                MADV_WILLNEED);
+    }
+    if (flags & SORTED_FILE_WILLNEED)
+        madvise(file->map, file->length, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (flags & SORTED_FILE_HUGEPAGES)
+        madvise(file->map, file->length, MADV_HUGEPAGE);
+#endif
+    return file;
+}
+
+// Sorted keys and the layouts built from them, for the benchmark
+typedef struct {
+    const int *arr;
+    int n;
+    EytzingerIndex *eytzinger;
+    STreeIndex *stree;
+    LearnedIndex *learned;
+} SearchData;
+
+// Every variant answers a batch of queries; results are either an index
+// of the target or -1 (exact), or the lower bound position (bound)
+typedef struct {
+    const char *name;
+    void (*run)(const SearchData *data, const int queries[], int count, int results[]);
+    int bound;
+} SearchVariant;
+
+void run_iterative(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = binary_search_iterative((int *)data->arr, 0, data->n - 1, queries[q]);
+}
+
+void run_recursive(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = binary_search_recursive((int *)data->arr, 0, data->n - 1, queries[q]);
+}
+
+void run_branchless(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = lower_bound_branchless(data->arr, data->n, queries[q]);
+}
+
+void run_eytzinger(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = lower_bound_eytzinger(data->eytzinger, queries[q]);
+}
+
+void run_batch(const SearchData *data, const int queries[], int count, int results[]) {
+    binary_search_batch(data->arr, data->n, queries, count, results);
+}
+
+void run_eytzinger_batch(const SearchData *data, const int queries[], int count, int results[]) {
+    lower_bound_eytzinger_batch(data->eytzinger, queries, count, results);
+}
+
+void run_stree(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = stree_search(data->stree, queries[q]);
+}
+
+void run_interpolation(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = lower_bound_interpolation(data->arr, data->n, queries[q]);
+}
+
+void run_learned(const SearchData *data, const int queries[], int count, int results[]) {
+    for (int q = 0; q < count; q++)
+        results[q] = learned_search(data->learned, queries[q]);
+}
+
+SearchVariant search_variants[] = {
+    {"iterative",  run_iterative,       0},
+    {"recursive",  run_recursive,       0},
+    {"branchless", run_branchless,      1},
+    {"eytzinger",  run_eytzinger,       1},
+    {"batched",    run_batch,           0},
+    {"batch eytz", run_eytzinger_batch, 1},
+    {"S+ tree",    run_stree,           0},
+    {"interp",     run_interpolation,   1},
+    {"learned",    run_learned,         0},
+};
+
+#define NUM_SEARCH_VARIANTS ((int)(sizeof(search_variants) / sizeof(search_variants[0])))
+
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+unsigned int xorshift32(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Checks results[] against a lower bound search: positions if bound, else
+// an index of the target or -1. Keys must be distinct for the latter.
+int results_correct(const int arr[], int n, const int query[], int queries,
+                    const int results[], int bound) {
+    int ok = 1;
+    for (int q = 0; q < queries; q++) {
+        int lb = lower_bound_branchless(arr, n, query[q]);
+        int found = lb < n && arr[lb] == query[q];
+        ok &= results[q] == (bound ? lb : (found ? lb : -1));
+    }
+    return ok;
+}
+
+// Times every variant on random lookups into sorted arrays of 1K keys up
+// to max_n, growing 4x per step so the array moves from L1 through L2 and
+// L3 into DRAM. Keys are distinct with random gaps; about half of the
+// queries hit. Each result is checked against a scalar lower bound.
+void search_benchmark(int max_n, int queries) {
+    int *arr = malloc((size_t)max_n * sizeof(int));
+    int *query = malloc((size_t)queries * sizeof(int));
+    int *results = malloc((size_t)queries * sizeof(int));
+    unsigned int state = 2463534242u;
+
+    if (!arr || !query || !results) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    arr[0] = 0;
+    for (int i = 1; i < max_n; i++)
+        arr[i] = arr[i - 1] + 1 + (int)(xorshift32(&state) % 3);
+
+    printf("\n%d random lookups per size, ns per lookup:\n", queries);
+    printf("%12s %10s", "n", "bytes");
+    for (int v = 0; v < NUM_SEARCH_VARIANTS; v++)
+        printf(" %11s", search_variants[v].name);
+    printf("\n");
+
+    for (long size = 1024; size < 4L * max_n; size *= 4) {
+        int n = (size > max_n) ? max_n : (int)size;
+        SearchData data = {arr, n, create_eytzinger_index(arr, n), create_stree_index(arr, n),
+                           create_learned_index(arr, n)};
+        double bytes = (double)n * sizeof(int);
+
+        for (int q = 0; q < queries; q++)
+            query[q] = (int)(xorshift32(&state) % ((unsigned int)arr[n - 1] + 2)) - 1;
+
+        printf("%12d %9.0f%c", n, bytes >= 1 << 20 ? bytes / (1 << 20) : bytes / 1024,
+               bytes >= 1 << 20 ? 'M' : 'K');
+        for (int v = 0; v < NUM_SEARCH_VARIANTS; v++) {
+            SearchVariant *variant = &search_variants[v];
+            int ok;
+
+            double start = wall_time();
+            variant->run(&data, query, queries, results);
+            double seconds = wall_time() - start;
+
+            ok = results_correct(arr, n, query, queries, results, variant->bound);
+            printf(" %10.1f%s", seconds * 1e9 / queries, ok ? " " : "!");
+        }
+        printf("\n");
+        free_eytzinger_index(data.eytzinger);
+        free_stree_index(data.stree);
+        free_learned_index(data.learned);
+        if (n == max_n)
+            break;
+    }
+    printf("(! marks a variant that returned a wrong result)\n");
+
+    free(arr);
+    free(query);
+    free(results);
+}
+
+// Build time, memory and lookup latency of each index over n distinct keys
+// from three distributions: uniform gaps (sequential ids), clustered
+// (dense bursts separated by large jumps, like event timestamps) and
+// power (key ~ (i/n)^6, dense at the bottom and sparse at the top, the
+// worst case for interpolation). Queries are stored keys, half of them
+// shifted by one to miss.
+void index_benchmark(int n, int queries) {
+    const char *distributions[] = { "uniform", "clustered", "power" };
+    int *arr = malloc((size_t)n * sizeof(int));
+    int *query = malloc((size_t)queries * sizeof(int));
+    int *results = malloc((size_t)queries * sizeof(int));
+    unsigned int state = 2463534242u;
+
+    if (!arr || !query || !results) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    printf("\n%d keys, %d lookups\n", n, queries);
+    printf("%-10s %-26s %10s %12s %12s  %s\n", "Keys", "Index", "Build ms",
+           "Index bytes", "ns/lookup", "Result");
+    // Jumps of the clustered keys average 1e9 / (n / 1000) so that they fit in an int
+    unsigned int max_jump = (unsigned int)(2e9 / (n / 1000 + 1));
+
+    for (int d = 0; d < 3; d++) {
+        long key = INT_MIN / 2;
+        for (int i = 0; i < n; i++) {
+            if (d == 0)
+                key += 1 + xorshift32(&state) % 3;
+            else if (d == 1)
+                key += (xorshift32(&state) % 1000 == 0) ? 1 + xorshift32(&state) % max_jump : 1;
+            else {
+                double x = (double)i / n;
+                key = INT_MIN / 2 + i + (long)(1.5e9 * x * x * x * x * x * x);
+            }
+            arr[i] = (int)key;
+        }
+        for (int q = 0; q < queries; q++)
+            query[q] = arr[xorshift32(&state) % n] + (int)(xorshift32(&state) & 1);
+
+        SearchData data = {arr, n, NULL, NULL, NULL};
+        double build[3];
+        double start = wall_time();
+        data.eytzinger = create_eytzinger_index(arr, n);
+        build[0] = wall_time() - start;
+        start = wall_time();
+        data.stree = create_stree_index(arr, n);
+        build[1] = wall_time() - start;
+        start = wall_time();
+        data.learned = create_learned_index(arr, n);
+        build[2] = wall_time() - start;
+
+        struct {
+            const char *name;
+            void (*run)(const SearchData *data, const int queries[], int count, int results[]);
+            int bound;
+            double build;
+            size_t bytes;
+        } rows[] = {
+            {"binary_search_iterative", run_iterative,     0, 0, 0},
+            {"interpolation",           run_interpolation, 1, 0, 0},
+            {"eytzinger",               run_eytzinger,     1, build[0], ((size_t)n + 1) * sizeof(int)},
+            {"S+ tree",                 run_stree,         0, build[1],
+             (size_t)data.stree->offset[data.stree->height] * sizeof(int)},
+            {"learned (PGM)",           run_learned,       0, build[2], learned_index_bytes(data.learned)},
+        };
+
+        for (int row = 0; row < (int)(sizeof(rows) / sizeof(rows[0])); row++) {
+            start = wall_time();
+            rows[row].run(&data, query, queries, results);
+            double seconds = wall_time() - start;
+            int ok = results_correct(arr, n, query, queries, results, rows[row].bound);
+            printf("%-10s %-26s %10.1f %12zu %12.1f  %s\n", distributions[d], rows[row].name,
+                   rows[row].build * 1e3, rows[row].bytes, seconds * 1e9 / queries,
+                   ok ? "ok" : "WRONG");
+        }
+        printf("%-10s %d learned segments over the keys, %d levels\n", "",
+               data.learned->level[0].count, data.learned->levels);
+
+        free_eytzinger_index(data.eytzinger);
+        free_stree_index(data.stree);
+        free_learned_index(data.learned);
+    }
+
+    free(arr);
+    free(query);
+    free(results);
+}
+
 void print_array(int arr[], int size) {
     printf("Array: ");
     for (int i = 0; i < size; i++) {
@@ -41,9 +1065,257 @@ void print_array(int arr[], int size) {
     printf("\n");
 }
 
-int main() {
+void print_usage(const char *program) {
+    printf("Usage:\n");
+    printf("  %s                                  Interactive search\n", program);
+    printf("  %s --benchmark [max_n] [queries]     Search variants, L1 to DRAM sizes\n", program);
+    printf("  %s --index-benchmark [n] [queries]   Index build time, memory and latency\n", program);
+    printf("  %s --make-file PATH N [--eytzinger]  Write a sorted array file of N keys\n", program);
+    printf("  %s --make-file PATH --text|--raw INPUT [--eytzinger]\n", program);
+    printf("      Convert sorted keys (decimal text or raw int32; INPUT - is stdin)\n");
+    printf("  %s --search-file PATH [--willneed] [--hugepages] [key ...]\n", program);
+    printf("      Map PATH and look up the keys, or time random lookups if none are given\n");
+}
+
+// Reads up to limit keys from in, as whitespace-separated decimal text or
+// raw native int32, and checks they are in non-decreasing order. Returns
+// the keys (count in *n), or NULL with the reason printed.
+int *read_sorted_keys(FILE *in, const char *name, int raw, int limit, int *n) {
+    size_t capacity = 1 << 20, count = 0;
+    int *keys = malloc(capacity * sizeof(int));
+    int valid = 1;
+
+    if (!keys) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    while (valid) {
+        if (count == capacity) {
+            capacity *= 2;
+            keys = realloc(keys, capacity * sizeof(int));
+            if (!keys) {
+                printf("Memory allocation failed!\n");
+                exit(1);
+            }
+        }
+        size_t got;
+        if (raw) {
+            size_t bytes = fread(keys + count, 1, (capacity - count) * sizeof(int), in);
+            got = bytes / sizeof(int);
+            if (bytes % sizeof(int) != 0) {
+                printf("%s: size is not a whole number of 4-byte keys\n", name);
+                valid = 0;
+            }
+        } else {
+            long long key;
+            got = 0;
+            while (count + got < capacity && fscanf(in, "%lld", &key) == 1) {
+                if (key < INT_MIN || key > INT_MAX) {
+                    printf("%s: key %lld does not fit a 32-bit int\n", name, key);
+                    valid = 0;
+                    break;
+                }
+                keys[count + got++] = (int)key;
+            }
+            if (valid && count + got < capacity && !ferror(in) && !feof(in)) {
+                printf("%s: not an integer after key %zu\n", name, count + got);
+                valid = 0;
+            }
+        }
+        for (size_t i = (count > 0) ? count : 1; valid && i < count + got; i++) {
+            if (keys[i] < keys[i - 1]) {
+                printf("%s: keys are not sorted: key %zu (%d) follows %d\n",
+                       name, i, keys[i], keys[i - 1]);
+                valid = 0;
+            }
+        }
+        count += got;
+        if (ferror(in)) {
+            perror(name);
+            valid = 0;
+        } else if (count > (size_t)limit) {
+            printf("%s: more than %d keys\n", name, limit);
+            valid = 0;
+        } else if (count < capacity) {
+            break;
+        }
+    }
+    if (valid && count == 0) {
+        printf("%s: no keys\n", name);
+        valid = 0;
+    }
+    if (!valid) {
+        free(keys);
+        return NULL;
+    }
+    *n = (int)count;
+    return keys;
+}
+
+// Writes a sorted array file from N generated keys (random gaps of 1-3), or
+// from the sorted keys of an existing dataset. Generated keys go straight
+// into the file's mapping, so no heap copy of them is made.
+int make_file_main(int argc, char *argv[]) {
+    const char *count_arg = NULL, *input = NULL;
+    int with_eytzinger = 0, raw = 0, valid = 1;
+
+    for (int i = 3; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--eytzinger") == 0) {
+            with_eytzinger = 1;
+        } else if (strcmp(argv[i], "--text") == 0 || strcmp(argv[i], "--raw") == 0) {
+            valid = !input && i + 1 < argc;
+            raw = strcmp(argv[i], "--raw") == 0;
+            input = argv[++i];
+        } else if (!count_arg) {
+            count_arg = argv[i];
+        } else {
+            valid = 0;
+        }
+    }
+    // Exactly one source: a key count or an input dataset
+    if (!valid || !count_arg == !input) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    int limit = with_eytzinger ? EYTZINGER_MAX_N : 1 << 30;
+
+    if (input) {
+        FILE *in = strcmp(input, "-") == 0 ? stdin : fopen(input, raw ? "rb" : "r");
+        if (!in) {
+            perror(input);
+            return 1;
+        }
+        double start = wall_time();
+        int n;
+        int *keys = read_sorted_keys(in, input, raw, limit, &n);
+        if (in != stdin)
+            fclose(in);
+        if (!keys)
+            return 1;
+        int status = write_sorted_file(argv[2], keys, n, with_eytzinger);
+        free(keys);
+        if (status < 0)
+            return 1;
+        printf("Converted %d keys from %s to %s%s in %.2f seconds\n", n, input, argv[2],
+               with_eytzinger ? ", with Eytzinger section" : "", wall_time() - start);
+        return 0;
+    }
+
+    double value = strtod(count_arg, NULL);
+    if (value < 1 || value > limit) {
+        printf("N must be between 1 and %d\n", limit);
+        return 1;
+    }
+    int n = (int)value;
+
+    SortedFile file;
+    double start = wall_time();
+    if (begin_sorted_file(argv[2], n, with_eytzinger, &file) < 0)
+        return 1;
+    int *keys = (int *)file.keys;
+    unsigned int state = 2463534242u;
+    keys[0] = INT_MIN;
+    for (int i = 1; i < n; i++)
+        keys[i] = keys[i - 1] + 1 + (int)(xorshift32(&state) % 3);
+    if (finish_sorted_file(&file) < 0)
+        return 1;
+    printf("Wrote %d keys (%.1f MB%s) to %s in %.2f seconds\n", n,
+           (double)file.length / (1 << 20), with_eytzinger ? ", with Eytzinger section" : "",
+           argv[2], wall_time() - start);
+    return 0;
+}
+
+int search_file_main(int argc, char *argv[]) {
+    int flags = 0, first_key = argc;
+
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--willneed") == 0)
+            flags |= SORTED_FILE_WILLNEED;
+        else if (strcmp(argv[i], "--hugepages") == 0)
+            flags |= SORTED_FILE_HUGEPAGES;
+        else if (first_key == argc)
+            first_key = i;
+    }
+
+    double start = wall_time();
+    SortedFile *file = open_sorted_file(argv[2], flags);
+    if (!file)
+        return 1;
+    printf("Opened %s: %d keys%s in %.3f ms\n", argv[2], file->n,
+           file->has_eytzinger ? " with Eytzinger section" : "", (wall_time() - start) * 1e3);
+
+    for (int i = first_key; i < argc; i++) {
+        if (argv[i][0] == '-' && argv[i][1] == '-')
+            continue;
+        int key = atoi(argv[i]);
+        int pos = file->has_eytzinger ? lower_bound_eytzinger(&file->eytzinger, key)
+                                      : lower_bound_branchless(file->keys, file->n, key);
+        if (pos < file->n && file->keys[pos] == key)
+            printf("Element %d found at index %d\n", key, pos);
+        else
+            printf("Element %d not found; the next larger key is at index %d\n", key, pos);
+    }
+
+    // Without keys: the first pass faults pages in from disk or the page
+    // cache, the second runs on mapped pages
+    if (first_key == argc && file->n > 0) {
+        int queries = 1 << 20;
+        unsigned int state = 88172645u;
+        long long checksum = 0;
+        // Keys are drawn from [first key, last key] in unsigned arithmetic;
+        // a span of all 2^32 values takes the raw random word
+        unsigned int lo = file->keys[0];
+        unsigned int span = (unsigned int)file->keys[file->n - 1] - lo;
+
+        for (int pass = 0; pass < 2; pass++) {
+            start = wall_time();
+            for (int q = 0; q < queries; q++) {
+                unsigned int offset = xorshift32(&state);
+                if (span != UINT_MAX)
+                    offset %= span + 1;
+                int key = (int)(lo + offset);
+                checksum += file->has_eytzinger ? lower_bound_eytzinger(&file->eytzinger, key)
+                                                : lower_bound_branchless(file->keys, file->n, key);
+            }
+            printf("%s pass: %.1f ns per lookup (%d lookups)\n", pass ? "Second" : "First",
+                   (wall_time() - start) * 1e9 / queries, queries);
+        }
+        printf("Checksum %lld\n", checksum);
+    }
+    close_sorted_file(file);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
     int size, target, choice;
     
+    if (argc > 1) {
+        if (strcmp(argv[1], "--make-file") == 0)
+            return make_file_main(argc, argv);
+        if (strcmp(argv[1], "--search-file") == 0)
+            return search_file_main(argc, argv);
+        int index = strcmp(argv[1], "--index-benchmark") == 0;
+        if (!index && strcmp(argv[1], "--benchmark") != 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        int max_n = (argc > 2) ? (int)strtod(argv[2], NULL) : 1 << 24;
+        int queries = (argc > 3) ? (int)strtod(argv[3], NULL) : 1 << 20;
+        if (max_n < 1 || queries < 1) {
+            printf("max_n and queries must be positive\n");
+            return 1;
+        }
+        if (index)
+            index_benchmark(max_n, queries);
+        else
+            search_benchmark(max_n, queries);
+        return 0;
+    }
+    
     printf("Enter array size: ");
     scanf("%d", &size);
     
@@ -66,11 +1338,42 @@ int main() {
     printf("Choose search method:\n");
     printf("1. Iterative Binary Search\n");
     printf("2. Recursive Binary Search\n");
-    printf("Enter choice (1 or 2): ");
+    printf("3. Lower bound (branchless)\n");
+    printf("4. Upper bound (branchless)\n");
+    printf("5. Lower bound (Eytzinger layout)\n");
+    printf("6. Upper bound (Eytzinger layout)\n");
+    printf("7. S+ tree (SIMD static B+ tree)\n");
+    printf("8. Interpolation search\n");
+    printf("9. Learned index (piecewise linear)\n");
+    printf("Enter choice (1-9): ");
     scanf("%d", &choice);
     
     int result = -1;
     
+    if (choice >= 3 && choice <= 6) {
+        EytzingerIndex *index = create_eytzinger_index(arr, size);
+        int upper = (choice == 4 || choice == 6);
+        
+        if (choice == 3)
+            result = lower_bound_branchless(arr, size, target);
+        else if (choice == 4)
+            result = upper_bound_branchless(arr, size, target);
+        else if (choice == 5)
+            result = lower_bound_eytzinger(index, target);
+        else
+            result = upper_bound_eytzinger(index, target);
+        
+        if (result < size)
+            printf("First element %s %d is %d at index %d\n", upper ? ">" : ">=",
+                   target, arr[result], result);
+        else
+            printf("No element %s %d (bound is index %d, the end)\n", upper ? ">" : ">=",
+                   target, result);
+        free_eytzinger_index(index);
+        free(arr);
+        return 0;
+    }
+    
     switch (choice) {
         case 1:
             result = binary_search_iterative(arr, 0, size - 1, target);
@@ -80,6 +1383,28 @@ int main() {
             result = binary_search_recursive(arr, 0, size - 1, target);
             printf("Using Recursive Binary Search:\n");
             break;
+        case 7: {
+            STreeIndex *tree = create_stree_index(arr, size);
+            result = stree_search(tree, target);
+            printf("Using S+ tree (%d layers, %s node search):\n", tree->height,
+                   tree->avx2 ? "AVX2" : "scalar");
+            free_stree_index(tree);
+            break;
+        }
+        case 8:
+            result = lower_bound_interpolation(arr, size, target);
+            if (result == size || arr[result] != target)
+                result = -1;
+            printf("Using Interpolation Search:\n");
+            break;
+        case 9: {
+            LearnedIndex *index = create_learned_index(arr, size);
+            result = learned_search(index, target);
+            printf("Using learned index (%d segments, %zu bytes):\n",
+                   index->level[0].count, learned_index_bytes(index));
+            free_learned_index(index);
+            break;
+        }
         default:
             printf("Invalid choice! Using iterative search by default.\n");
             result = binary_search_iterative(arr, 0, size - 1, target);
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include "../PerfCounters/perf_counters.h"
 
 #define MAX_NODES 100
 #define INF INT_MAX
@@ -79,17 +80,20 @@ void dijkstra(t_graph *g, int start) {
 
 		visited[u] = 1;
 
+		PERF_REGION_BEGIN("dijkstra_relax");
 		for (t_edge *e = g->adj[u]; e; e = e->next) {
 			int v = e->to;
 			if (!visited[v] && dist[u] + e->weight < dist[v])
 				dist[v] = dist[u] + e->weight;
 		}
+		PERF_REGION_END();
 	}
 	print_distances(dist, g->num_nodes, start);
 }
 
 int main(void) {
 	int n, m;
+	perf_counters_init();
 	printf("Number of nodes: ");
 	if (scanf("%d", &n) != 1 || n <= 0 || n > MAX_NODES) {
 		fprintf(stderr, "Invalid number of nodes.\n");
@@ -127,6 +131,7 @@ int main(void) {
 	}
 
 	dijkstra(g, start);
+	perf_counters_report(stdout);
 	free_graph(g);
 	return EXIT_SUCCESS;
 }
@@ -2,24 +2,94 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "../PerfCounters/perf_counters.h"
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
-// Binary Heap structure
+// Children per node of the Heap priority queue; build with -DHEAP_ARITY=8
+// (and -mavx2) for an 8-ary heap, or -DHEAP_ARITY=2 for a binary one. The
+// heap sort functions below always use binary heaps on plain arrays.
+#ifndef HEAP_ARITY
+#define HEAP_ARITY 4
+#endif
+#if HEAP_ARITY < 2
+#error "HEAP_ARITY must be at least 2"
+#endif
+
+#define CACHE_LINE 64
+
+// Operation counters for SortBenchmark. With -DSORT_STATS every key
+// comparison and swap made by the sequential sorts is counted in globals
+// that the harness defines; otherwise the hooks compile to nothing.
+#ifdef SORT_STATS
+extern long long sort_comparisons;
+extern long long sort_swaps;
+#define COUNT_COMPARISON() (sort_comparisons++)
+#define COUNT_SWAP() (sort_swaps++)
+#else
+#define COUNT_COMPARISON() ((void)0)
+#define COUNT_SWAP() ((void)0)
+#endif
+
+// d-ary Heap structure. The storage grows geometrically as keys are
+// inserted; capacity is only the current allocation.
 typedef struct {
-    int *data;
+    int *data;      // Element i of the heap; points into block
+    int *block;     // Cache-line aligned allocation holding data
     int size;
     int capacity;
 } Heap;
 
+// Bytes currently allocated for Heap storage, their high-water mark and
+// the number of resizes, for the growth benchmark. Atomic because the
+// heaps of a MultiQueue grow from several threads.
+atomic_llong heap_bytes = 0;
+atomic_llong heap_peak_bytes = 0;
+atomic_llong heap_resize_count = 0;
+
+// Indexed min heap: heap slots hold ids, position maps ids back to slots
+typedef struct {
+    int *keys;      // keys[id]: current key of id
+    int *ids;       // ids[slot]: id stored in that heap slot
+    int *position;  // position[id]: slot of id, or -1 if id is not queued
+    int size;
+    int capacity;   // Valid ids are 0..capacity-1
+} IndexedHeap;
+
+// One lock-protected heap of a MultiQueue, padded to its own cache lines
+typedef struct {
+    _Alignas(CACHE_LINE) pthread_mutex_t lock;
+    Heap *heap;
+    atomic_int top;    // Largest key while size > 0, readable without the lock
+    atomic_int size;   // Number of keys, readable without the lock
+} MultiQueueShard;
+
+typedef struct {
+    MultiQueueShard *shards;
+    int num_shards;
+} MultiQueue;
+
 // Function prototypes
 Heap* create_heap(int capacity);
 void free_heap(Heap* heap);
-void swap(int *a, int *b);
+int heap_reserve(Heap* heap, int capacity);
+void heap_shrink_to_fit(Heap* heap);
+int heap_push(Heap* heap, int key);
+int heap_push_many(Heap* heap, const int keys[], int count);
+int heap_meld(Heap* heap, Heap* other);
 void max_heapify(int arr[], int n, int i);
 void min_heapify(int arr[], int n, int i);
 void build_max_heap(int arr[], int n);
 void build_min_heap(int arr[], int n);
 void heap_sort_ascending(int arr[], int n);
 void heap_sort_descending(int arr[], int n);
+void partial_sort(int arr[], int n, int k);
 void insert_heap(Heap* heap, int key);
 int extract_max(Heap* heap);
 int extract_min(Heap* heap);
@@ -28,155 +98,524 @@ int get_min(Heap* heap);
 void increase_key(Heap* heap, int i, int new_key);
 void decrease_key(Heap* heap, int i, int new_key);
 void delete_key(Heap* heap, int i);
-void print_array(int arr[], int n);
 void print_heap(Heap* heap);
-void copy_array(int source[], int dest[], int n);
 int is_max_heap(int arr[], int n);
 int is_min_heap(int arr[], int n);
+unsigned int xorshift32(unsigned int *state);
+void heap_sort_benchmark(int arr[], int n);
+void priority_queue_benchmark(int n);
+int indexed_heap_self_test(int capacity, int operations);
+void heap_growth_benchmark(int n);
+void heap_bulk_benchmark(int n);
+void top_k_benchmark(int n);
+int multiqueue_stress_test(int threads, int keys_per_thread);
+void multiqueue_benchmark(int max_threads, int prefill, int operations);
+
+// Size of the block holding `capacity` elements: data starts
+// HEAP_ARITY - 1 slots into a cache-line aligned block, so the children of
+// node i, data[d*i + 1 .. d*i + d], start at block[d*(i+1)] and a full
+// sibling group (16 bytes for d = 4, 32 for d = 8) always sits inside one
+// cache line. Rounded up to whole cache lines, as aligned_alloc requires.
+size_t heap_block_bytes(int capacity) {
+    size_t bytes = ((size_t)capacity + HEAP_ARITY - 1) * sizeof(int);
+    bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    return bytes > 0 ? bytes : CACHE_LINE;
+}
 
-// Create a new heap
+// Move the heap to a block for exactly `capacity` elements (>= size).
+// aligned_alloc has no realloc counterpart, so the keys are copied; both
+// blocks are alive during the copy, which the peak accounts for.
+// Returns 0 on success, -1 if the allocation fails (heap unchanged).
+int heap_resize(Heap* heap, int capacity) {
+    size_t bytes = heap_block_bytes(capacity);
+    int *block = aligned_alloc(CACHE_LINE, bytes);
+    if (!block)
+        return -1;
+    
+    long long in_use = atomic_fetch_add(&heap_bytes, bytes) + bytes;
+    long long peak = atomic_load(&heap_peak_bytes);
+    while (in_use > peak && !atomic_compare_exchange_weak(&heap_peak_bytes, &peak, in_use))
+        ;
+    atomic_fetch_add(&heap_resize_count, 1);
+    
+    if (heap->size > 0)
+        memcpy(block + HEAP_ARITY - 1, heap->data, heap->size * sizeof(int));
+    if (heap->block) {
+        free(heap->block);
+        atomic_fetch_sub(&heap_bytes, heap_block_bytes(heap->capacity));
+    }
+    heap->block = block;
+    heap->data = block + HEAP_ARITY - 1;
+    heap->capacity = capacity;
+    return 0;
+}
+
+// Create a new heap with room for `capacity` keys before it first grows
 Heap* create_heap(int capacity) {
     Heap* heap = malloc(sizeof(Heap));
     if (!heap) {
         printf("Memory allocation failed!\n");
         exit(1);
     }
-    heap->data = malloc(capacity * sizeof(int));
-    if (!heap->data) {
+    heap->block = NULL;
+    heap->data = NULL;
+    heap->size = 0;
+    heap->capacity = 0;
+    if (heap_resize(heap, capacity > 0 ? capacity : 0) != 0) {
         printf("Memory allocation failed!\n");
         free(heap);
         exit(1);
     }
-    heap->size = 0;
-    heap->capacity = capacity;
+    atomic_fetch_sub(&heap_resize_count, 1);  // The first allocation is not a resize
     return heap;
 }
 
 // Free heap memory
 void free_heap(Heap* heap) {
     if (heap) {
-        free(heap->data);
+        atomic_fetch_sub(&heap_bytes, heap_block_bytes(heap->capacity));
+        free(heap->block);
         free(heap);
     }
 }
 
-// Swap two integers
-void swap(int *a, int *b) {
-    int temp = *a;
-    *a = *b;
-    *b = temp;
+// Make room for at least `capacity` keys in one step, e.g. before a batch
+// of known size. Returns 0 on success, -1 if the allocation fails.
+int heap_reserve(Heap* heap, int capacity) {
+    if (capacity <= heap->capacity)
+        return 0;
+    return heap_resize(heap, capacity);
+}
+
+// Double the capacity of a full heap (amortized O(1) per insert)
+int heap_grow(Heap* heap) {
+    if (heap->capacity == INT_MAX)
+        return -1;
+    if (heap->capacity > INT_MAX / 2)
+        return heap_resize(heap, INT_MAX);
+    return heap_resize(heap, heap->capacity > 0 ? 2 * heap->capacity : 1);
+}
+
+// Release unused capacity, e.g. after a burst of inserts has drained
+void heap_shrink_to_fit(Heap* heap) {
+    if (heap->size < heap->capacity)
+        heap_resize(heap, heap->size);  // On failure the heap just stays large
+}
+
+// Heap sort engine specialized at compile time for any element type.
+// DEFINE_HEAP_SORT(name, type, less) expands to
+//   void name##_heapify(type arr[], int n, int i); // sift arr[i] down
+//   void name##_build(type arr[], int n);           // bottom-up build
+//   void name(type arr[], int n);                   // in-place heap sort
+//   void name##_sift_to_leaf(type arr[], int n, int i, type x);
+//   void name##_floyd(type arr[], int n);           // Floyd's heap sort
+//   void name##_partial(type arr[], int n, int k);  // k smallest, sorted
+// with the comparison macro less(a, b) inlined. The heap keeps the greatest
+// element by `less` at the root, so the array ends up ascending by `less`.
+//
+// name##_heapify compares both children and the parent at every level, so
+// name costs about 2n log2 n comparisons. name##_floyd uses Floyd's
+// bottom-up variant instead: the element being placed is held aside and a
+// hole walks down to a leaf along the larger children (one comparison per
+// level), then x bounces back up from the leaf. Since x is usually small
+// (it was just taken from the bottom of the heap) it rarely climbs, and the
+// whole sort takes about n log2 n comparisons with no swaps.
+//
+// name##_partial leaves the k smallest elements by `less` in arr[0..k-1] in
+// ascending order (the rest in unspecified order) in O(n log k) time and
+// O(1) space: a max heap of the first k elements is kept, and every later
+// element smaller than its root replaces the root. With a greater-than
+// comparison, as in heap_sort_descending_partial, this is top-k selection.
+#define DEFINE_HEAP_SORT(name, type, less)                                     \
+void name##_heapify(type arr[], int n, int i) {                                \
+    PERF_REGION_BEGIN(#name "_heapify");                                       \
+    int largest = i;                                                           \
+    int left = 2 * i + 1;                                                      \
+    int right = 2 * i + 2;                                                     \
+                                                                               \
+    if (left < n && less(arr[largest], arr[left]))                             \
+        largest = left;                                                        \
+    if (right < n && less(arr[largest], arr[right]))                           \
+        largest = right;                                                       \
+                                                                               \
+    if (largest != i) {                                                        \
+        COUNT_SWAP();                                                          \
+        type temp = arr[i];                                                    \
+        arr[i] = arr[largest];                                                 \
+        arr[largest] = temp;                                                   \
+                                                                               \
+        /* Recursively heapify the affected sub-tree */                       \
+        name##_heapify(arr, n, largest);                                       \
+    }                                                                          \
+    PERF_REGION_END();                                                         \
+}                                                                              \
+                                                                               \
+void name##_build(type arr[], int n) {                                         \
+    /* Start from rightmost internal node and heapify all internal nodes */   \
+    for (int i = n / 2 - 1; i >= 0; i--) {                                     \
+        name##_heapify(arr, n, i);                                             \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name(type arr[], int n) {                                                 \
+    name##_build(arr, n);                                                      \
+                                                                               \
+    /* One by one move the root to the end and heapify the reduced heap */    \
+    for (int i = n - 1; i > 0; i--) {                                          \
+        COUNT_SWAP();                                                          \
+        type temp = arr[0];                                                    \
+        arr[0] = arr[i];                                                       \
+        arr[i] = temp;                                                         \
+        name##_heapify(arr, i, 0);                                             \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+/* Place x in the subtree rooted at the hole arr[i] of a heap of n */          \
+/* elements: move the hole down to a leaf, then sift x up to i at most. */     \
+void name##_sift_to_leaf(type arr[], int n, int i, type x) {                   \
+    int hole = i;                                                              \
+    int child;                                                                 \
+                                                                               \
+    /* Both children exist: step to the larger one without a branch */         \
+    while ((child = 2 * hole + 2) < n) {                                       \
+        child -= less(arr[child], arr[child - 1]);                             \
+        arr[hole] = arr[child];                                                \
+        hole = child;                                                          \
+    }                                                                          \
+    if (child == n) {                                                          \
+        /* Only a left child */                                                \
+        arr[hole] = arr[n - 1];                                                \
+        hole = n - 1;                                                          \
+    }                                                                          \
+                                                                               \
+    while (hole > i) {                                                         \
+        int parent = (hole - 1) / 2;                                           \
+        if (!less(arr[parent], x))                                             \
+            break;                                                             \
+        arr[hole] = arr[parent];                                               \
+        hole = parent;                                                         \
+    }                                                                          \
+    arr[hole] = x;                                                             \
+}                                                                              \
+                                                                               \
+void name##_floyd(type arr[], int n) {                                         \
+    for (int i = n / 2 - 1; i >= 0; i--)                                       \
+        name##_sift_to_leaf(arr, n, i, arr[i]);                                \
+                                                                               \
+    /* The root moves to the end; the displaced last element refills it */     \
+    for (int i = n - 1; i > 0; i--) {                                          \
+        type x = arr[i];                                                       \
+        arr[i] = arr[0];                                                       \
+        name##_sift_to_leaf(arr, i, 0, x);                                     \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name##_partial(type arr[], int n, int k) {                                \
+    if (k > n)                                                                 \
+        k = n;                                                                 \
+    if (k <= 0)                                                                \
+        return;                                                                \
+                                                                               \
+    /* Max heap of the k smallest elements seen so far */                      \
+    name##_build(arr, k);                                                      \
+    for (int i = k; i < n; i++) {                                              \
+        if (less(arr[i], arr[0])) {                                            \
+            COUNT_SWAP();                                                      \
+            type temp = arr[0];                                                \
+            arr[0] = arr[i];                                                   \
+            arr[i] = temp;                                                     \
+            name##_heapify(arr, k, 0);                                         \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* Sort the kept elements as in name##_floyd */                            \
+    for (int i = k - 1; i > 0; i--) {                                          \
+        type x = arr[i];                                                       \
+        arr[i] = arr[0];                                                       \
+        name##_sift_to_leaf(arr, i, 0, x);                                     \
+    }                                                                          \
+}
+
+// 16-byte record: sort key plus an opaque payload (e.g. a row id)
+typedef struct {
+    long long key;
+    long long payload;
+} KeyPayload;
+
+#define SCALAR_LESS(a, b) (COUNT_COMPARISON(), (a) < (b))
+#define SCALAR_GREATER(a, b) (COUNT_COMPARISON(), (a) > (b))
+#define KEY_LESS(a, b) SCALAR_LESS((a).key, (b).key)
+
+// Specializations for common key types. Ascending order uses a max heap,
+// descending order a min heap. Floats must not contain NaN.
+DEFINE_HEAP_SORT(heap_sort_ascending, int, SCALAR_LESS)
+DEFINE_HEAP_SORT(heap_sort_descending, int, SCALAR_GREATER)
+DEFINE_HEAP_SORT(heap_sort_i64, long long, SCALAR_LESS)
+DEFINE_HEAP_SORT(heap_sort_float, float, SCALAR_LESS)
+DEFINE_HEAP_SORT(heap_sort_pair, KeyPayload, KEY_LESS)
+
+// Comparison-counting instances, used only by the benchmark
+long long comparison_count = 0;
+
+#define COUNTED_LESS(a, b) (comparison_count++, (a) < (b))
+#define COUNTED_GREATER(a, b) (comparison_count++, (a) > (b))
+
+DEFINE_HEAP_SORT(counted_ascending, int, COUNTED_LESS)
+DEFINE_HEAP_SORT(counted_descending, int, COUNTED_GREATER)
+
+// Sort the k smallest elements of arr[0..n-1] into arr[0..k-1], ascending.
+// Use heap_sort_descending_partial for the k largest, descending.
+void partial_sort(int arr[], int n, int k) {
+    heap_sort_ascending_partial(arr, n, k);
 }
 
 // Heapify a subtree rooted with node i (Max Heap)
 void max_heapify(int arr[], int n, int i) {
-    int largest = i;    // Initialize largest as root
-    int left = 2 * i + 1;   // Left child
-    int right = 2 * i + 2;  // Right child
-    
-    // If left child is larger than root
-    if (left < n && arr[left] > arr[largest])
-        largest = left;
-    
-    // If right child is larger than largest so far
-    if (right < n && arr[right] > arr[largest])
-        largest = right;
-    
-    // If largest is not root
-    if (largest != i) {
-        swap(&arr[i], &arr[largest]);
-        
-        // Recursively heapify the affected sub-tree
-        max_heapify(arr, n, largest);
-    }
+    heap_sort_ascending_heapify(arr, n, i);
 }
 
 // Heapify a subtree rooted with node i (Min Heap)
 void min_heapify(int arr[], int n, int i) {
-    int smallest = i;    // Initialize smallest as root
-    int left = 2 * i + 1;    // Left child
-    int right = 2 * i + 2;   // Right child
-    
-    // If left child is smaller than root
-    if (left < n && arr[left] < arr[smallest])
-        smallest = left;
-    
-    // If right child is smaller than smallest so far
-    if (right < n && arr[right] < arr[smallest])
-        smallest = right;
-    
-    // If smallest is not root
-    if (smallest != i) {
-        swap(&arr[i], &arr[smallest]);
-        
-        // Recursively heapify the affected sub-tree
-        min_heapify(arr, n, smallest);
-    }
+    heap_sort_descending_heapify(arr, n, i);
 }
 
 // Build a max heap from array
 void build_max_heap(int arr[], int n) {
-    // Start from rightmost internal node and heapify all internal nodes
-    for (int i = n / 2 - 1; i >= 0; i--) {
-        max_heapify(arr, n, i);
-    }
+    heap_sort_ascending_build(arr, n);
 }
 
 // Build a min heap from array
 void build_min_heap(int arr[], int n) {
-    // Start from rightmost internal node and heapify all internal nodes
-    for (int i = n / 2 - 1; i >= 0; i--) {
-        min_heapify(arr, n, i);
+    heap_sort_descending_build(arr, n);
+}
+
+// Comparator in the qsort convention: negative, zero or positive
+typedef int (*compare_function)(const void *a, const void *b);
+
+static void swap_bytes(void *a, void *b, size_t size) {
+    unsigned char *p = a, *q = b;
+    while (size--) {
+        unsigned char temp = *p;
+        *p++ = *q;
+        *q++ = temp;
     }
 }
 
-// Heap sort (ascending order)
-void heap_sort_ascending(int arr[], int n) {
-    // Build max heap
-    build_max_heap(arr, n);
-    
-    // One by one extract an element from heap
-    for (int i = n - 1; i > 0; i--) {
-        // Move current root to end
-        swap(&arr[0], &arr[i]);
+// Iterative sift-down of element i in a max heap of n elements
+void generic_heapify(char *base, size_t n, size_t i, size_t size, compare_function cmp) {
+    while (1) {
+        size_t largest = i;
+        size_t left = 2 * i + 1;
+        size_t right = 2 * i + 2;
         
-        // Call max heapify on the reduced heap
-        max_heapify(arr, i, 0);
+        if (left < n && cmp(base + largest * size, base + left * size) < 0)
+            largest = left;
+        if (right < n && cmp(base + largest * size, base + right * size) < 0)
+            largest = right;
+        if (largest == i)
+            return;
+        
+        swap_bytes(base + i * size, base + largest * size, size);
+        i = largest;
     }
 }
 
-// Heap sort (descending order)
-void heap_sort_descending(int arr[], int n) {
-    // Build min heap
-    build_min_heap(arr, n);
+// Heap sort with a qsort-compatible interface: count elements of `size`
+// bytes each, ascending by cmp. Prefer a DEFINE_HEAP_SORT specialization on
+// hot paths, which inlines the comparison instead of calling through cmp.
+void heap_sort_generic(void *base, size_t count, size_t size, compare_function cmp) {
+    char *bytes = base;
     
-    // One by one extract an element from heap
-    for (int i = n - 1; i > 0; i--) {
-        // Move current root to end
-        swap(&arr[0], &arr[i]);
-        
-        // Call min heapify on the reduced heap
-        min_heapify(arr, i, 0);
+    if (count < 2)
+        return;
+    
+    for (size_t i = count / 2; i-- > 0; )
+        generic_heapify(bytes, count, i, size, cmp);
+    
+    for (size_t i = count - 1; i > 0; i--) {
+        swap_bytes(bytes, bytes + i * size, size);
+        generic_heapify(bytes, i, 0, size, cmp);
+    }
+}
+
+// Priority queue primitives for the Heap struct, on a HEAP_ARITY-ary heap:
+// node i has children HEAP_ARITY * i + 1 .. HEAP_ARITY * i + HEAP_ARITY and
+// parent (i - 1) / HEAP_ARITY. A wider heap is shallower (log_d n levels),
+// so extraction touches fewer cache lines at the price of d - 1 comparisons
+// per level, which the SIMD helpers below do in a few instructions. The
+// Heap storage is laid out so every full group of siblings is aligned and
+// never straddles a cache line (see create_heap).
+#if HEAP_ARITY == 8 && defined(__AVX2__)
+#define HEAP_SIMD 1
+
+// Index (0-7) of the largest of the 8 ints at p
+int heap_simd_max_index(const int p[]) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i m = _mm256_max_epi32(v, _mm256_permute2x128_si256(v, v, 1));
+    m = _mm256_max_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm256_max_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return __builtin_ctz(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, m))));
+}
+
+// Index (0-7) of the smallest of the 8 ints at p
+int heap_simd_min_index(const int p[]) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i m = _mm256_min_epi32(v, _mm256_permute2x128_si256(v, v, 1));
+    m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return __builtin_ctz(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, m))));
+}
+#elif HEAP_ARITY == 4 && defined(__SSE4_1__)
+#define HEAP_SIMD 1
+
+// Index (0-3) of the largest of the 4 ints at p
+int heap_simd_max_index(const int p[]) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_max_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return __builtin_ctz(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, m))));
+}
+
+// Index (0-3) of the smallest of the 4 ints at p
+int heap_simd_min_index(const int p[]) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return __builtin_ctz(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, m))));
+}
+#else
+// Scalar scan only (other arities, or built without -msse4.1 / -mavx2)
+#define HEAP_SIMD 0
+#define heap_simd_max_index(p) 0
+#define heap_simd_min_index(p) 0
+#endif
+
+// DEFINE_DARY_HEAP(name, better, simd_index) expands to
+//   int name##_child(const int data[], int first, int count);
+//   void name##_sift_up(int data[], int i);
+//   void name##_sift_down(int data[], int n, int i);
+// for a heap that keeps the element that is `better` than its children at
+// the root. Both sifts move a hole instead of swapping.
+#define DEFINE_DARY_HEAP(name, better, simd_index)                             \
+/* Index of the best of the count siblings starting at data[first] */          \
+int name##_child(const int data[], int first, int count) {                     \
+    if (HEAP_SIMD && count == HEAP_ARITY)                                      \
+        return first + simd_index(data + first);                               \
+                                                                               \
+    int best = first;                                                          \
+    for (int c = first + 1; c < first + count; c++) {                          \
+        if (better(data[c], data[best]))                                       \
+            best = c;                                                          \
+    }                                                                          \
+    return best;                                                               \
+}                                                                              \
+                                                                               \
+void name##_sift_up(int data[], int i) {                                       \
+    int key = data[i];                                                         \
+                                                                               \
+    while (i > 0) {                                                            \
+        int parent = (i - 1) / HEAP_ARITY;                                     \
+        if (!better(key, data[parent]))                                        \
+            break;                                                             \
+        data[i] = data[parent];                                                \
+        i = parent;                                                            \
+    }                                                                          \
+    data[i] = key;                                                             \
+}                                                                              \
+                                                                               \
+void name##_sift_down(int data[], int n, int i) {                              \
+    int key = data[i];                                                         \
+                                                                               \
+    while (1) {                                                                \
+        int first = HEAP_ARITY * i + 1;                                        \
+        if (first >= n)                                                        \
+            break;                                                             \
+        int count = (n - first < HEAP_ARITY) ? n - first : HEAP_ARITY;         \
+        int child = name##_child(data, first, count);                          \
+        if (!better(data[child], key))                                         \
+            break;                                                             \
+        data[i] = data[child];                                                 \
+        i = child;                                                             \
+    }                                                                          \
+    data[i] = key;                                                             \
+}
+
+DEFINE_DARY_HEAP(heap_max, SCALAR_GREATER, heap_simd_max_index)
+DEFINE_DARY_HEAP(heap_min, SCALAR_LESS, heap_simd_min_index)
+
+// Insert a key into a max heap without printing, growing it when full.
+// Returns 0 on success, -1 if the heap cannot grow.
+int heap_push(Heap* heap, int key) {
+    if (heap->size == heap->capacity && heap_grow(heap) != 0)
+        return -1;
+    
+    // Insert the new key at the end and sift it up to its place
+    heap->data[heap->size] = key;
+    heap_max_sift_up(heap->data, heap->size);
+    heap->size++;
+    return 0;
+}
+
+// Restore the max heap order over the whole Heap bottom-up (Floyd): O(n)
+void heap_rebuild(Heap* heap) {
+    for (int i = (heap->size - 2) / HEAP_ARITY; i >= 0; i--)
+        heap_max_sift_down(heap->data, heap->size, i);
+}
+
+// Insert a batch of keys into a max heap. Small batches are sifted up one
+// by one, O(count log n); when count * log2(n) exceeds n the keys are
+// appended and the heap is rebuilt bottom-up instead, O(n). Returns 0 on
+// success, -1 if the heap cannot grow (nothing is inserted then).
+int heap_push_many(Heap* heap, const int keys[], int count) {
+    if (count <= 0)
+        return 0;
+    if (count > INT_MAX - heap->size)
+        return -1;
+    
+    int total = heap->size + count;
+    if (total > heap->capacity) {
+        // Grow geometrically, as single inserts do
+        int capacity = heap->capacity > INT_MAX / 2 ? INT_MAX : 2 * heap->capacity;
+        if (heap_reserve(heap, capacity > total ? capacity : total) != 0)
+            return -1;
+    }
+    
+    int log_total = 0;
+    for (int m = total; m > 1; m >>= 1)
+        log_total++;
+    
+    if ((long long)count * log_total > total) {
+        memcpy(heap->data + heap->size, keys, count * sizeof(int));
+        heap->size = total;
+        heap_rebuild(heap);
+    } else {
+        for (int i = 0; i < count; i++) {
+            heap->data[heap->size] = keys[i];
+            heap_max_sift_up(heap->data, heap->size);
+            heap->size++;
+        }
     }
+    return 0;
+}
+
+// Move every key of the max heap `other` into `heap` in O(n + m); `other`
+// is left empty. Returns 0 on success, -1 if `heap` cannot grow.
+int heap_meld(Heap* heap, Heap* other) {
+    if (heap == other || other->size == 0)
+        return 0;
+    if (heap_push_many(heap, other->data, other->size) != 0)
+        return -1;
+    other->size = 0;
+    return 0;
 }
 
 // Insert a new key into max heap
 void insert_heap(Heap* heap, int key) {
-    if (heap->size >= heap->capacity) {
+    if (heap_push(heap, key) != 0) {
         printf("Heap overflow! Cannot insert %d\n", key);
         return;
     }
     
-    // First insert the new key at the end
-    heap->size++;
-    int i = heap->size - 1;
-    heap->data[i] = key;
-    
-    // Fix the max heap property if it is violated
-    while (i != 0 && heap->data[(i - 1) / 2] < heap->data[i]) {
-        swap(&heap->data[i], &heap->data[(i - 1) / 2]);
-        i = (i - 1) / 2;
-    }
-    
     printf("Inserted %d into heap.\n", key);
 }
 
@@ -195,7 +634,7 @@ int extract_max(Heap* heap) {
     int root = heap->data[0];
     heap->data[0] = heap->data[heap->size - 1];
     heap->size--;
-    max_heapify(heap->data, heap->size, 0);
+    heap_max_sift_down(heap->data, heap->size, 0);
     
     return root;
 }
@@ -215,7 +654,7 @@ int extract_min(Heap* heap) {
     int root = heap->data[0];
     heap->data[0] = heap->data[heap->size - 1];
     heap->size--;
-    min_heapify(heap->data, heap->size, 0);
+    heap_min_sift_down(heap->data, heap->size, 0);
     
     return root;
 }
@@ -250,10 +689,7 @@ void increase_key(Heap* heap, int i, int new_key) {
     }
     
     heap->data[i] = new_key;
-    while (i != 0 && heap->data[(i - 1) / 2] < heap->data[i]) {
-        swap(&heap->data[i], &heap->data[(i - 1) / 2]);
-        i = (i - 1) / 2;
-    }
+    heap_max_sift_up(heap->data, i);
     printf("Key increased successfully.\n");
 }
 
@@ -269,10 +705,7 @@ void decrease_key(Heap* heap, int i, int new_key) {
     }
     
     heap->data[i] = new_key;
-    while (i != 0 && heap->data[(i - 1) / 2] > heap->data[i]) {
-        swap(&heap->data[i], &heap->data[(i - 1) / 2]);
-        i = (i - 1) / 2;
-    }
+    heap_min_sift_up(heap->data, i);
     printf("Key decreased successfully.\n");
 }
 
@@ -287,24 +720,282 @@ void delete_key(Heap* heap, int i) {
     heap->data[i] = heap->data[heap->size - 1];
     heap->size--;
     
-    // Heapify from the changed node
-    max_heapify(heap->data, heap->size, i);
-    
-    // Also check if we need to move up
-    while (i != 0 && heap->data[(i - 1) / 2] < heap->data[i]) {
-        swap(&heap->data[i], &heap->data[(i - 1) / 2]);
-        i = (i - 1) / 2;
+    // The moved key may belong below or above slot i
+    if (i < heap->size) {
+        heap_max_sift_down(heap->data, heap->size, i);
+        heap_max_sift_up(heap->data, i);
     }
     
     printf("Key deleted successfully.\n");
 }
 
-// Print array
-void print_array(int arr[], int n) {
-    for (int i = 0; i < n; i++) {
-        printf("%d ", arr[i]);
+// Indexed (addressable) min heap over external ids 0..capacity-1, e.g.
+// graph vertices or task handles. position[id] tracks the slot of every id,
+// so keys can be changed or removed by id in O(log n) without searching.
+// Uses the same HEAP_ARITY as Heap. Operations return 0 on success and -1
+// when the id is out of range or not (or already) in the heap.
+IndexedHeap* create_indexed_heap(int capacity) {
+    IndexedHeap* heap = malloc(sizeof(IndexedHeap));
+    if (!heap) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    heap->keys = malloc(capacity * sizeof(int));
+    heap->ids = malloc(capacity * sizeof(int));
+    heap->position = malloc(capacity * sizeof(int));
+    if (!heap->keys || !heap->ids || !heap->position) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int id = 0; id < capacity; id++)
+        heap->position[id] = -1;
+    heap->size = 0;
+    heap->capacity = capacity;
+    return heap;
+}
+
+void free_indexed_heap(IndexedHeap* heap) {
+    if (heap) {
+        free(heap->keys);
+        free(heap->ids);
+        free(heap->position);
+        free(heap);
+    }
+}
+
+int indexed_heap_contains(IndexedHeap* heap, int id) {
+    return id >= 0 && id < heap->capacity && heap->position[id] >= 0;
+}
+
+// Move id up from slot i until its parent's key is not larger
+void indexed_sift_up(IndexedHeap* heap, int i, int id) {
+    int key = heap->keys[id];
+    
+    while (i > 0) {
+        int parent = (i - 1) / HEAP_ARITY;
+        int parent_id = heap->ids[parent];
+        if (heap->keys[parent_id] <= key)
+            break;
+        heap->ids[i] = parent_id;
+        heap->position[parent_id] = i;
+        i = parent;
+    }
+    heap->ids[i] = id;
+    heap->position[id] = i;
+}
+
+// Move id down from slot i until no child has a smaller key
+void indexed_sift_down(IndexedHeap* heap, int i, int id) {
+    int key = heap->keys[id];
+    
+    while (1) {
+        int first = HEAP_ARITY * i + 1;
+        if (first >= heap->size)
+            break;
+        int last = (first + HEAP_ARITY < heap->size) ? first + HEAP_ARITY : heap->size;
+        int child = first;
+        for (int c = first + 1; c < last; c++) {
+            if (heap->keys[heap->ids[c]] < heap->keys[heap->ids[child]])
+                child = c;
+        }
+        int child_id = heap->ids[child];
+        if (heap->keys[child_id] >= key)
+            break;
+        heap->ids[i] = child_id;
+        heap->position[child_id] = i;
+        i = child;
+    }
+    heap->ids[i] = id;
+    heap->position[id] = i;
+}
+
+int indexed_heap_insert(IndexedHeap* heap, int id, int key) {
+    if (id < 0 || id >= heap->capacity || heap->position[id] >= 0)
+        return -1;
+    
+    heap->keys[id] = key;
+    heap->size++;
+    indexed_sift_up(heap, heap->size - 1, id);
+    return 0;
+}
+
+// Id with the smallest key, or -1 if the heap is empty
+int indexed_heap_min(IndexedHeap* heap) {
+    return heap->size > 0 ? heap->ids[0] : -1;
+}
+
+// Remove and return the id with the smallest key (-1 if empty); its key
+// is stored in *key when key is not NULL
+int indexed_heap_extract_min(IndexedHeap* heap, int *key) {
+    if (heap->size == 0)
+        return -1;
+    
+    int id = heap->ids[0];
+    if (key)
+        *key = heap->keys[id];
+    heap->position[id] = -1;
+    heap->size--;
+    if (heap->size > 0)
+        indexed_sift_down(heap, 0, heap->ids[heap->size]);
+    return id;
+}
+
+// Set the key of id to any new value, moving it up or down as needed
+int indexed_heap_change_key(IndexedHeap* heap, int id, int key) {
+    if (!indexed_heap_contains(heap, id))
+        return -1;
+    
+    int old_key = heap->keys[id];
+    heap->keys[id] = key;
+    if (key < old_key)
+        indexed_sift_up(heap, heap->position[id], id);
+    else
+        indexed_sift_down(heap, heap->position[id], id);
+    return 0;
+}
+
+// Lower the key of id, e.g. when Dijkstra relaxes an edge. Fails if the
+// new key is larger than the current one.
+int indexed_heap_decrease_key(IndexedHeap* heap, int id, int key) {
+    if (!indexed_heap_contains(heap, id) || key > heap->keys[id])
+        return -1;
+    
+    heap->keys[id] = key;
+    indexed_sift_up(heap, heap->position[id], id);
+    return 0;
+}
+
+int indexed_heap_remove(IndexedHeap* heap, int id) {
+    if (!indexed_heap_contains(heap, id))
+        return -1;
+    
+    int i = heap->position[id];
+    heap->position[id] = -1;
+    heap->size--;
+    if (i < heap->size) {
+        // Refill the hole with the last id, which may belong above or below
+        int last_id = heap->ids[heap->size];
+        indexed_sift_down(heap, i, last_id);
+        indexed_sift_up(heap, heap->position[last_id], last_id);
+    }
+    return 0;
+}
+
+// Concurrent relaxed max priority queue (MultiQueue). Keys are spread over
+// num_shards Heaps, each behind its own mutex; use about two shards per
+// thread. An insert goes to a random shard. An extraction samples two
+// random shards, peeks at their cached maxima without locking and pops
+// from the better one. Any shard whose lock is taken is skipped rather
+// than waited for, so threads rarely contend.
+//
+// The result is relaxed: an extraction returns a key close to the global
+// maximum (among the largest few per shard), not necessarily the maximum
+// itself. Every inserted key is still extracted exactly once.
+MultiQueue* create_multiqueue(int num_shards) {
+    MultiQueue* mq = malloc(sizeof(MultiQueue));
+    if (!mq) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    if (num_shards < 1)
+        num_shards = 1;
+    mq->shards = aligned_alloc(CACHE_LINE, num_shards * sizeof(MultiQueueShard));
+    if (!mq->shards) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_shards; i++) {
+        MultiQueueShard *shard = &mq->shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->heap = create_heap(0);
+        atomic_init(&shard->top, 0);
+        atomic_init(&shard->size, 0);
+    }
+    mq->num_shards = num_shards;
+    return mq;
+}
+
+void free_multiqueue(MultiQueue* mq) {
+    if (mq) {
+        for (int i = 0; i < mq->num_shards; i++) {
+            pthread_mutex_destroy(&mq->shards[i].lock);
+            free_heap(mq->shards[i].heap);
+        }
+        free(mq->shards);
+        free(mq);
+    }
+}
+
+// Publish a locked shard's maximum and size for lock-free peeking
+void multiqueue_publish(MultiQueueShard *shard) {
+    Heap *heap = shard->heap;
+    if (heap->size > 0)
+        atomic_store_explicit(&shard->top, heap->data[0], memory_order_relaxed);
+    atomic_store_explicit(&shard->size, heap->size, memory_order_relaxed);
+}
+
+// Insert key; seed is the calling thread's PRNG state. Returns 0 on
+// success, -1 if the chosen shard cannot grow.
+int multiqueue_insert(MultiQueue* mq, int key, unsigned int *seed) {
+    while (1) {
+        MultiQueueShard *shard = &mq->shards[xorshift32(seed) % mq->num_shards];
+        if (pthread_mutex_trylock(&shard->lock) != 0)
+            continue;
+        
+        int result = heap_push(shard->heap, key);
+        multiqueue_publish(shard);
+        pthread_mutex_unlock(&shard->lock);
+        return result;
+    }
+}
+
+// Remove a key close to the maximum into *key. Returns 0 on success, or -1
+// once every shard is seen empty (a key inserted concurrently with that
+// check may be missed).
+int multiqueue_extract_max(MultiQueue* mq, int *key, unsigned int *seed) {
+    int misses = 0;
+    
+    while (1) {
+        if (++misses > 2 * mq->num_shards) {
+            int empty = 1;
+            for (int i = 0; i < mq->num_shards && empty; i++)
+                empty = atomic_load_explicit(&mq->shards[i].size, memory_order_relaxed) == 0;
+            if (empty)
+                return -1;
+            misses = 0;
+        }
+        
+        // Two random choices; prefer the non-empty shard with the larger top
+        MultiQueueShard *a = &mq->shards[xorshift32(seed) % mq->num_shards];
+        MultiQueueShard *b = &mq->shards[xorshift32(seed) % mq->num_shards];
+        int size_a = atomic_load_explicit(&a->size, memory_order_relaxed);
+        int size_b = atomic_load_explicit(&b->size, memory_order_relaxed);
+        if (size_a == 0 && size_b == 0)
+            continue;
+        
+        MultiQueueShard *shard;
+        if (size_a == 0)
+            shard = b;
+        else if (size_b == 0)
+            shard = a;
+        else
+            shard = atomic_load_explicit(&a->top, memory_order_relaxed) >=
+                    atomic_load_explicit(&b->top, memory_order_relaxed) ? a : b;
+        
+        if (pthread_mutex_trylock(&shard->lock) != 0)
+            continue;
+        Heap *heap = shard->heap;
+        if (heap->size == 0) {
+            pthread_mutex_unlock(&shard->lock);
+            continue;
+        }
+        *key = heap->data[0];
+        heap->data[0] = heap->data[--heap->size];
+        heap_max_sift_down(heap->data, heap->size, 0);
+        multiqueue_publish(shard);
+        pthread_mutex_unlock(&shard->lock);
+        return 0;
     }
-    printf("\n");
 }
 
 // Print heap with tree-like structure
@@ -314,6 +1005,7 @@ void print_heap(Heap* heap) {
         return;
     }
     
+    printf("Size %d, capacity %d\n", heap->size, heap->capacity);
     printf("Heap elements: ");
     for (int i = 0; i < heap->size; i++) {
         printf("%d ", heap->data[i]);
@@ -334,14 +1026,7 @@ void print_heap(Heap* heap) {
         }
         printf("\n");
         level++;
-        level_size *= 2;
-    }
-}
-
-// Copy array
-void copy_array(int source[], int dest[], int n) {
-    for (int i = 0; i < n; i++) {
-        dest[i] = source[i];
+        level_size *= HEAP_ARITY;
     }
 }
 
@@ -373,13 +1058,610 @@ int is_min_heap(int arr[], int n) {
     return 1;
 }
 
+// Small, fast PRNG for the MultiQueue shard choice and the benchmarks, so
+// key generation does not dominate
+unsigned int xorshift32(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// SortBenchmark builds this file with -DSORT_NO_MAIN and calls the sorts
+// itself; the menu, its helpers and the benchmarks below are left out
+#ifndef SORT_NO_MAIN
+
+// Print array
+static void print_array(int arr[], int n) {
+    for (int i = 0; i < n; i++) {
+        printf("%d ", arr[i]);
+    }
+    printf("\n");
+}
+
+// Copy array
+static void copy_array(int source[], int dest[], int n) {
+    for (int i = 0; i < n; i++) {
+        dest[i] = source[i];
+    }
+}
+
 // Generate random array for testing
-void generate_random_array(int arr[], int n, int max_val) {
+static void generate_random_array(int arr[], int n, int max_val) {
     for (int i = 0; i < n; i++) {
         arr[i] = rand() % max_val + 1;
     }
 }
 
+// Time the classic and Floyd heap sorts in both orders on copies of arr,
+// count their comparisons and check the results
+void heap_sort_benchmark(int arr[], int n) {
+    const char *names[] = {
+        "heap_sort_ascending",
+        "heap_sort_ascending_floyd",
+        "heap_sort_descending",
+        "heap_sort_descending_floyd"
+    };
+    int *temp = malloc(n * sizeof(int));
+    
+    if (!temp) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    printf("\n%-28s %12s %14s %12s  %s\n", "Method", "Seconds",
+           "Comparisons", "/ n log2 n", "Result");
+    for (int method = 0; method < 4; method++) {
+        copy_array(arr, temp, n);
+        clock_t start = clock();
+        switch (method) {
+            case 0: heap_sort_ascending(temp, n); break;
+            case 1: heap_sort_ascending_floyd(temp, n); break;
+            case 2: heap_sort_descending(temp, n); break;
+            default: heap_sort_descending_floyd(temp, n); break;
+        }
+        clock_t end = clock();
+        
+        int ok = 1;
+        for (int i = 1; i < n; i++) {
+            if (method < 2 ? temp[i - 1] > temp[i] : temp[i - 1] < temp[i]) {
+                ok = 0;
+                break;
+            }
+        }
+        
+        // Same algorithm again, through the comparison-counting instance
+        copy_array(arr, temp, n);
+        comparison_count = 0;
+        switch (method) {
+            case 0: counted_ascending(temp, n); break;
+            case 1: counted_ascending_floyd(temp, n); break;
+            case 2: counted_descending(temp, n); break;
+            default: counted_descending_floyd(temp, n); break;
+        }
+        
+        printf("%-28s %12f %14lld %12.3f  %s\n", names[method],
+               ((double)(end - start)) / CLOCKS_PER_SEC, comparison_count,
+               n > 1 ? comparison_count / (n * log2(n)) : 0.0,
+               ok ? "sorted" : "NOT SORTED");
+    }
+    
+    free(temp);
+}
+
+// Priority queue workload on a max heap of n keys: n inserts, n mixed
+// operations (extract the maximum, insert a new key) at full size, then n
+// extractions, which are checked to come out in non-increasing order. Runs
+// once on a plain binary heap driven by max_heapify, as the baseline, and
+// once on the Heap struct with its HEAP_ARITY-ary layout.
+void priority_queue_benchmark(int n) {
+    const char *names[] = { "binary (max_heapify)", "Heap" };
+    char heap_name[64];
+    
+    snprintf(heap_name, sizeof(heap_name), "Heap (d = %d%s)", HEAP_ARITY,
+             HEAP_SIMD ? ", SIMD" : "");
+    names[1] = heap_name;
+    
+    printf("\n%d elements, ns per operation:\n", n);
+    printf("%-24s %10s %10s %10s  %s\n", "Layout", "Insert", "Mixed",
+           "Extract", "Result");
+    for (int variant = 0; variant < 2; variant++) {
+        Heap *heap = create_heap(n);
+        int *data = heap->data;
+        unsigned int state = 2463534242u;
+        int ok = 1;
+        double seconds[3];
+        clock_t start;
+        
+        // Insert
+        start = clock();
+        for (int i = 0; i < n; i++) {
+            int key = xorshift32(&state) >> 1;
+            if (variant == 0) {
+                int j = i;
+                while (j > 0 && data[(j - 1) / 2] < key) {
+                    data[j] = data[(j - 1) / 2];
+                    j = (j - 1) / 2;
+                }
+                data[j] = key;
+            } else {
+                data[i] = key;
+                heap_max_sift_up(data, i);
+            }
+        }
+        seconds[0] = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        
+        // Mixed: replace the maximum with a fresh key
+        start = clock();
+        for (int i = 0; i < n; i++) {
+            data[0] = xorshift32(&state) >> 1;
+            if (variant == 0)
+                max_heapify(data, n, 0);
+            else
+                heap_max_sift_down(data, n, 0);
+        }
+        seconds[1] = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        
+        // Extract everything
+        int previous = data[0];
+        start = clock();
+        for (int size = n; size > 0; size--) {
+            int top = data[0];
+            data[0] = data[size - 1];
+            if (variant == 0)
+                max_heapify(data, size - 1, 0);
+            else
+                heap_max_sift_down(data, size - 1, 0);
+            ok &= top <= previous;
+            previous = top;
+        }
+        seconds[2] = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        
+        printf("%-24s %10.1f %10.1f %10.1f  %s\n", names[variant],
+               seconds[0] * 1e9 / n, seconds[1] * 1e9 / n, seconds[2] * 1e9 / n,
+               ok ? "ordered" : "NOT ORDERED");
+        free_heap(heap);
+    }
+}
+
+// Stream n random keys into a Heap three ways: reserved up front, grown by
+// doubling from empty, and grown then drained to 10% and shrunk to fit.
+// Reports insert throughput, resizes and the storage high-water mark.
+void heap_growth_benchmark(int n) {
+    const char *names[] = {
+        "reserve(n) up front",
+        "grow from empty",
+        "grow, drain 90%, shrink"
+    };
+    
+    printf("\n%d inserts (d = %d):\n", n, HEAP_ARITY);
+    printf("%-24s %10s %12s %8s %10s %10s\n", "Method", "Seconds",
+           "M inserts/s", "Resizes", "Peak MiB", "Final MiB");
+    for (int method = 0; method < 3; method++) {
+        unsigned int state = 2463534242u;
+        Heap* heap = create_heap(0);
+        
+        atomic_store(&heap_resize_count, 0);
+        atomic_store(&heap_peak_bytes, atomic_load(&heap_bytes));
+        if (method == 0 && heap_reserve(heap, n) != 0) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        
+        clock_t start = clock();
+        for (int i = 0; i < n; i++) {
+            if (heap_push(heap, xorshift32(&state) >> 1) != 0) {
+                printf("Heap overflow!\n");
+                exit(1);
+            }
+        }
+        double seconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        
+        if (method == 2) {
+            while (heap->size > n / 10) {
+                heap->data[0] = heap->data[--heap->size];
+                heap_max_sift_down(heap->data, heap->size, 0);
+            }
+            heap_shrink_to_fit(heap);
+        }
+        
+        printf("%-24s %10.4f %12.1f %8lld %10.1f %10.1f\n", names[method],
+               seconds, seconds > 0.0 ? n / seconds / 1e6 : 0.0,
+               atomic_load(&heap_resize_count), atomic_load(&heap_peak_bytes) / 1048576.0,
+               heap_block_bytes(heap->capacity) / 1048576.0);
+        free_heap(heap);
+    }
+}
+
+// Check the max heap order of a HEAP_ARITY-ary heap array
+int is_max_heap_dary(int arr[], int n) {
+    for (int i = 1; i < n; i++) {
+        if (arr[(i - 1) / HEAP_ARITY] < arr[i])
+            return 0;
+    }
+    return 1;
+}
+
+// Load n keys into a Heap one heap_push at a time and as one
+// heap_push_many batch, then meld two heaps of n/2 keys both by pushing
+// one into the other and with heap_meld. Random keys, then ascending keys
+// (the worst case for sifting up).
+void heap_bulk_benchmark(int n) {
+    int *keys = malloc(n * sizeof(int));
+    unsigned int state = 2463534242u;
+    
+    if (!keys) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    printf("\n%d keys (d = %d), seconds:\n", n, HEAP_ARITY);
+    printf("%-12s %12s %16s %14s %12s  %s\n", "Keys", "n x push",
+           "heap_push_many", "push-by-push", "heap_meld", "Result");
+    for (int ascending = 0; ascending < 2; ascending++) {
+        for (int i = 0; i < n; i++)
+            keys[i] = ascending ? i : (int)(xorshift32(&state) >> 1);
+        
+        double seconds[4];
+        int ok = 1;
+        for (int method = 0; method < 4; method++) {
+            Heap* heap = create_heap(0);
+            Heap* other = create_heap(0);
+            int half = n / 2;
+            
+            // The melds start from two heaps holding either half of the keys
+            if (method >= 2) {
+                heap_push_many(heap, keys, half);
+                heap_push_many(other, keys + half, n - half);
+            }
+            
+            clock_t start = clock();
+            switch (method) {
+                case 0:
+                    for (int i = 0; i < n; i++)
+                        heap_push(heap, keys[i]);
+                    break;
+                case 1:
+                    heap_push_many(heap, keys, n);
+                    break;
+                case 2:
+                    for (int i = 0; i < other->size; i++)
+                        heap_push(heap, other->data[i]);
+                    other->size = 0;
+                    break;
+                default:
+                    heap_meld(heap, other);
+                    break;
+            }
+            seconds[method] = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+            
+            ok &= heap->size == n && other->size == 0 &&
+                  is_max_heap_dary(heap->data, heap->size);
+            free_heap(heap);
+            free_heap(other);
+        }
+        
+        printf("%-12s %12f %16f %14f %12f  %s\n",
+               ascending ? "ascending" : "random", seconds[0], seconds[1],
+               seconds[2], seconds[3], ok ? "valid heaps" : "INVALID");
+    }
+    
+    free(keys);
+}
+
+// Top-k selection on n random keys: heap_sort_descending_partial against
+// sorting everything with heap_sort_descending, for several k
+void top_k_benchmark(int n) {
+    int ks[] = { 1, 10, 100, 1000, n / 100, n / 10 };
+    int *keys = malloc(n * sizeof(int));
+    int *full = malloc(n * sizeof(int));
+    int *temp = malloc(n * sizeof(int));
+    unsigned int state = 2463534242u;
+    
+    if (!keys || !full || !temp) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++)
+        keys[i] = xorshift32(&state) >> 1;
+    
+    copy_array(keys, full, n);
+    clock_t start = clock();
+    heap_sort_descending(full, n);
+    double full_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+    
+    printf("\nTop k of %d keys; full heap_sort_descending: %f seconds\n", n, full_time);
+    printf("%10s %14s %9s  %s\n", "k", "Partial (s)", "Speedup", "Result");
+    for (int t = 0; t < (int)(sizeof(ks) / sizeof(ks[0])); t++) {
+        int k = ks[t];
+        if (k < 1 || k > n || (t > 0 && k <= ks[t - 1]))
+            continue;
+        
+        copy_array(keys, temp, n);
+        start = clock();
+        heap_sort_descending_partial(temp, n, k);
+        double seconds = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        
+        printf("%10d %14f %8.1fx  %s\n", k, seconds,
+               seconds > 0.0 ? full_time / seconds : 0.0,
+               memcmp(temp, full, k * sizeof(int)) == 0 ? "matches full sort" : "MISMATCH");
+    }
+    
+    free(keys);
+    free(full);
+    free(temp);
+}
+
+static int default_thread_count(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+}
+
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    MultiQueue *mq;
+    Heap *heap;              // Single heap of the global-lock baseline
+    pthread_mutex_t *lock;   // Its lock
+    atomic_int *seen;        // Stress test: times each key was extracted
+    int id;
+    int operations;
+} QueueWorkerArg;
+
+// Stress worker: insert keys id*operations .. (id+1)*operations-1 and
+// extract after every other insert, counting each extracted key
+void *multiqueue_stress_worker(void *arg) {
+    QueueWorkerArg *work = arg;
+    unsigned int seed = 2463534242u + 7919u * work->id;
+    
+    for (int i = 0; i < work->operations; i++) {
+        if (multiqueue_insert(work->mq, work->id * work->operations + i, &seed) != 0) {
+            printf("Heap overflow!\n");
+            exit(1);
+        }
+        int key;
+        if (i % 2 == 1 && multiqueue_extract_max(work->mq, &key, &seed) == 0)
+            atomic_fetch_add(&work->seen[key], 1);
+    }
+    return NULL;
+}
+
+// Run threads that interleave inserts and extractions, drain the queue and
+// check every key came out exactly once
+int multiqueue_stress_test(int threads, int keys_per_thread) {
+    MultiQueue *mq = create_multiqueue(2 * threads);
+    int total = threads * keys_per_thread;
+    atomic_int *seen = calloc(total, sizeof(atomic_int));
+    pthread_t *tids = malloc(threads * sizeof(pthread_t));
+    QueueWorkerArg *args = malloc(threads * sizeof(QueueWorkerArg));
+    unsigned int seed = 1u;
+    int key, failures = 0;
+    
+    if (!seen || !tids || !args) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int t = 0; t < threads; t++) {
+        args[t] = (QueueWorkerArg){ mq, NULL, NULL, seen, t, keys_per_thread };
+        pthread_create(&tids[t], NULL, multiqueue_stress_worker, &args[t]);
+    }
+    for (int t = 0; t < threads; t++)
+        pthread_join(tids[t], NULL);
+    
+    while (multiqueue_extract_max(mq, &key, &seed) == 0)
+        atomic_fetch_add(&seen[key], 1);
+    for (int k = 0; k < total; k++) {
+        if (atomic_load(&seen[k]) != 1) {
+            if (failures++ < 5)
+                printf("Key %d extracted %d times\n", k, atomic_load(&seen[k]));
+        }
+    }
+    
+    free(seen);
+    free(tids);
+    free(args);
+    free_multiqueue(mq);
+    return failures == 0;
+}
+
+// Benchmark worker: alternate one insert and one extraction, either on the
+// MultiQueue or on one Heap behind a global mutex
+void *queue_benchmark_worker(void *arg) {
+    QueueWorkerArg *work = arg;
+    unsigned int seed = 2463534242u + 7919u * work->id;
+    int key;
+    
+    for (int i = 0; i < work->operations; i++) {
+        int new_key = xorshift32(&seed) >> 1;
+        if (work->mq) {
+            multiqueue_insert(work->mq, new_key, &seed);
+            multiqueue_extract_max(work->mq, &key, &seed);
+        } else {
+            pthread_mutex_lock(work->lock);
+            heap_push(work->heap, new_key);
+            Heap *heap = work->heap;
+            heap->data[0] = heap->data[--heap->size];
+            heap_max_sift_down(heap->data, heap->size, 0);
+            pthread_mutex_unlock(work->lock);
+        }
+    }
+    return NULL;
+}
+
+// Throughput of insert+extract pairs on a queue prefilled with `prefill`
+// keys, for 1, 2, 4, ... max_threads threads: one Heap behind a global
+// mutex against a MultiQueue with two shards per thread
+void multiqueue_benchmark(int max_threads, int prefill, int operations) {
+    printf("\n%d prefilled keys, %d insert+extract pairs per thread\n",
+           prefill, operations);
+    printf("%8s %18s %18s %9s\n", "Threads", "Global lock Mops/s",
+           "MultiQueue Mops/s", "Ratio");
+    
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads)
+            threads = max_threads;
+        
+        pthread_t *tids = malloc(threads * sizeof(pthread_t));
+        QueueWorkerArg *args = malloc(threads * sizeof(QueueWorkerArg));
+        double rate[2];
+        if (!tids || !args) {
+            printf("Memory allocation failed!\n");
+            exit(1);
+        }
+        
+        for (int variant = 0; variant < 2; variant++) {
+            pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+            Heap *heap = NULL;
+            MultiQueue *mq = NULL;
+            unsigned int seed = 12345u;
+            
+            if (variant == 0) {
+                heap = create_heap(prefill + threads);
+                for (int i = 0; i < prefill; i++)
+                    heap_push(heap, xorshift32(&seed) >> 1);
+            } else {
+                mq = create_multiqueue(2 * threads);
+                for (int i = 0; i < prefill; i++)
+                    multiqueue_insert(mq, xorshift32(&seed) >> 1, &seed);
+            }
+            
+            double start = wall_time();
+            for (int t = 0; t < threads; t++) {
+                args[t] = (QueueWorkerArg){ mq, heap, &lock, NULL, t, operations };
+                pthread_create(&tids[t], NULL, queue_benchmark_worker, &args[t]);
+            }
+            for (int t = 0; t < threads; t++)
+                pthread_join(tids[t], NULL);
+            double seconds = wall_time() - start;
+            rate[variant] = seconds > 0.0 ? 2.0 * threads * operations / seconds / 1e6 : 0.0;
+            
+            free_heap(heap);
+            free_multiqueue(mq);
+        }
+        
+        printf("%8d %18.2f %18.2f %8.2fx\n", threads, rate[0], rate[1],
+               rate[0] > 0.0 ? rate[1] / rate[0] : 0.0);
+        free(tids);
+        free(args);
+        if (threads == max_threads)
+            break;
+    }
+}
+
+// Check the heap order and the position map of an indexed heap
+int indexed_heap_valid(IndexedHeap* heap) {
+    int present = 0;
+    
+    for (int i = 0; i < heap->size; i++) {
+        if (heap->position[heap->ids[i]] != i)
+            return 0;
+        if (i > 0 && heap->keys[heap->ids[(i - 1) / HEAP_ARITY]] > heap->keys[heap->ids[i]])
+            return 0;
+    }
+    for (int id = 0; id < heap->capacity; id++)
+        present += heap->position[id] >= 0;
+    return present == heap->size;
+}
+
+// Randomized check of the indexed heap: interleave inserts, extractions,
+// key changes and removals by id, and compare every result with a plain
+// array of (present, key) scanned linearly
+int indexed_heap_self_test(int capacity, int operations) {
+    IndexedHeap* heap = create_indexed_heap(capacity);
+    int *keys = malloc(capacity * sizeof(int));
+    char *present = calloc(capacity, 1);
+    unsigned int state = 88172645u;
+    int failures = 0;
+    
+    if (!keys || !present) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    for (int op = 0; op < operations && failures == 0; op++) {
+        int id = xorshift32(&state) % capacity;
+        int key = xorshift32(&state) % (capacity * 4);
+        int expected, result;
+        
+        switch (xorshift32(&state) % 5) {
+            case 0:
+            case 1:
+                expected = present[id] ? -1 : 0;
+                result = indexed_heap_insert(heap, id, key);
+                if (result == 0) {
+                    present[id] = 1;
+                    keys[id] = key;
+                }
+                break;
+                
+            case 2: {
+                // Smallest key; any id holding it is a correct answer
+                int min_key = -1;
+                for (int j = 0; j < capacity; j++) {
+                    if (present[j] && (min_key < 0 || keys[j] < min_key))
+                        min_key = keys[j];
+                }
+                int extracted_key;
+                int extracted = indexed_heap_extract_min(heap, &extracted_key);
+                expected = min_key;
+                result = extracted < 0 ? -1 : extracted_key;
+                if (extracted >= 0) {
+                    if (!present[extracted] || keys[extracted] != extracted_key)
+                        result = -2;
+                    present[extracted] = 0;
+                }
+                break;
+            }
+                
+            case 3:
+                expected = (present[id] && key <= keys[id]) ? 0 : -1;
+                result = indexed_heap_decrease_key(heap, id, key);
+                if (result == 0)
+                    keys[id] = key;
+                break;
+                
+            default:
+                if (xorshift32(&state) % 2) {
+                    expected = present[id] ? 0 : -1;
+                    result = indexed_heap_change_key(heap, id, key);
+                    if (result == 0)
+                        keys[id] = key;
+                } else {
+                    expected = present[id] ? 0 : -1;
+                    result = indexed_heap_remove(heap, id);
+                    present[id] = 0;
+                }
+                break;
+        }
+        
+        if (result != expected || !indexed_heap_valid(heap)) {
+            printf("Mismatch at operation %d (id %d, key %d): got %d, expected %d\n",
+                   op, id, key, result, expected);
+            failures++;
+        }
+    }
+    
+    // Drain: keys must come out in non-decreasing order
+    int previous = -1, key;
+    while (failures == 0 && indexed_heap_extract_min(heap, &key) >= 0) {
+        if (key < previous) {
+            printf("Drain out of order: %d after %d\n", key, previous);
+            failures++;
+        }
+        previous = key;
+    }
+    
+    free(keys);
+    free(present);
+    free_indexed_heap(heap);
+    return failures == 0;
+}
+
 int main() {
     srand(time(NULL));
     
@@ -392,7 +1674,7 @@ int main() {
         printf("HEAP SORT:\n");
         printf("1. Heap Sort (Ascending)\n");
         printf("2. Heap Sort (Descending)\n");
-        printf("3. Compare with array sorting\n");
+        printf("3. Compare classic and Floyd heap sort\n");
         
         printf("\nMAX HEAP OPERATIONS:\n");
         printf("4. Create Max Heap\n");
@@ -416,6 +1698,12 @@ int main() {
         printf("18. Check if array is Min Heap\n");
         printf("19. Build heap from array\n");
         printf("20. Exit\n");
+        printf("21. Priority queue benchmark (d = %d)\n", HEAP_ARITY);
+        printf("22. Indexed heap self-test (decrease-key by id)\n");
+        printf("23. Heap growth benchmark (memory and insert throughput)\n");
+        printf("24. Bulk insert and meld benchmark\n");
+        printf("25. Concurrent MultiQueue stress test and thread scaling\n");
+        printf("26. Top-k (partial sort) benchmark\n");
         
         printf("Enter your choice: ");
         scanf("%d", &choice);
@@ -487,15 +1775,25 @@ int main() {
             }
             
             case 3: {
-                printf("This option would compare heap sort with other sorting algorithms.\n");
-                printf("You can implement quick sort and merge sort comparison here.\n");
+                int n;
+                printf("Enter array size: ");
+                scanf("%d", &n);
+                
+                int *arr = malloc(n * sizeof(int));
+                if (!arr) {
+                    printf("Memory allocation failed!\n");
+                    break;
+                }
+                generate_random_array(arr, n, RAND_MAX - 1);
+                heap_sort_benchmark(arr, n);
+                free(arr);
                 break;
             }
             
             case 4: {
                 if (max_heap) free_heap(max_heap);
                 int capacity;
-                printf("Enter max heap capacity: ");
+                printf("Enter initial max heap capacity (it grows as needed): ");
                 scanf("%d", &capacity);
                 max_heap = create_heap(capacity);
                 printf("Max heap created with capacity %d.\n", capacity);
@@ -575,7 +1873,7 @@ int main() {
             case 11: {
                 if (min_heap) free_heap(min_heap);
                 int capacity;
-                printf("Enter min heap capacity: ");
+                printf("Enter initial min heap capacity (it grows as needed): ");
                 scanf("%d", &capacity);
                 min_heap = create_heap(capacity);
                 printf("Min heap created with capacity %d.\n", capacity);
@@ -591,19 +1889,13 @@ int main() {
                 printf("Enter key to insert: ");
                 scanf("%d", &key);
                 // For min heap, we need to modify insertion logic
-                if (min_heap->size >= min_heap->capacity) {
+                if (min_heap->size == min_heap->capacity && heap_grow(min_heap) != 0) {
                     printf("Heap overflow!\n");
                     break;
                 }
+                min_heap->data[min_heap->size] = key;
+                heap_min_sift_up(min_heap->data, min_heap->size);
                 min_heap->size++;
-                int i = min_heap->size - 1;
-                min_heap->data[i] = key;
-                
-                // Fix min heap property
-                while (i != 0 && min_heap->data[(i - 1) / 2] > min_heap->data[i]) {
-                    swap(&min_heap->data[i], &min_heap->data[(i - 1) / 2]);
-                    i = (i - 1) / 2;
-                }
                 printf("Inserted %d into min heap.\n", key);
                 break;
             }
@@ -727,6 +2019,80 @@ int main() {
                 return 0;
             }
             
+            case 21: {
+                int n;
+                printf("Enter number of elements (e.g. 1000000 to 100000000): ");
+                scanf("%d", &n);
+                if (n > 0)
+                    priority_queue_benchmark(n);
+                break;
+            }
+            
+            case 22: {
+                int capacity, operations;
+                printf("Enter number of ids and operations: ");
+                scanf("%d %d", &capacity, &operations);
+                if (capacity <= 0 || operations < 0) {
+                    printf("Invalid sizes!\n");
+                    break;
+                }
+                if (indexed_heap_self_test(capacity, operations))
+                    printf("Indexed heap self-test PASSED (%d operations on %d ids)\n",
+                           operations, capacity);
+                else
+                    printf("Indexed heap self-test FAILED\n");
+                break;
+            }
+            
+            case 23: {
+                int n;
+                printf("Enter number of inserts: ");
+                scanf("%d", &n);
+                if (n > 0)
+                    heap_growth_benchmark(n);
+                break;
+            }
+            
+            case 24: {
+                int n;
+                printf("Enter number of keys: ");
+                scanf("%d", &n);
+                if (n > 0)
+                    heap_bulk_benchmark(n);
+                break;
+            }
+            
+            case 25: {
+                int threads = default_thread_count();
+                int requested, prefill, operations;
+                printf("Enter max threads (0 = %d online cores), prefilled keys and operations per thread: ",
+                       threads);
+                scanf("%d %d %d", &requested, &prefill, &operations);
+                if (requested > 0)
+                    threads = requested;
+                if (prefill < 0 || operations <= 0) {
+                    printf("Invalid sizes!\n");
+                    break;
+                }
+                
+                if (multiqueue_stress_test(threads, operations))
+                    printf("Stress test PASSED: %d threads x %d keys, each extracted exactly once\n",
+                           threads, operations);
+                else
+                    printf("Stress test FAILED\n");
+                multiqueue_benchmark(threads, prefill, operations);
+                break;
+            }
+            
+            case 26: {
+                int n;
+                printf("Enter number of keys: ");
+                scanf("%d", &n);
+                if (n > 0)
+                    top_k_benchmark(n);
+                break;
+            }
+            
             default:
                 printf("Invalid choice! Please try again.\n");
                 break;
@@ -735,3 +2101,4 @@ int main() {
     
     return 0;
 }
+#endif
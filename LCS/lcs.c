@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "../PerfCounters/perf_counters.h"
 
 // Function prototypes
 int lcs_recursive(char *str1, char *str2, int m, int n);
@@ -63,6 +64,7 @@ int lcs_dp(char *str1, char *str2, int m, int n) {
     int **dp = allocate_2d_array(m + 1, n + 1);
     
     // Build the DP table
+    PERF_REGION_BEGIN("lcs_dp_fill");
     for (int i = 0; i <= m; i++) {
         for (int j = 0; j <= n; j++) {
             if (i == 0 || j == 0)
@@ -73,6 +75,7 @@ int lcs_dp(char *str1, char *str2, int m, int n) {
                 dp[i][j] = max(dp[i-1][j], dp[i][j-1]);
         }
     }
+    PERF_REGION_END();
     
     int result = dp[m][n];
     free_2d_array(dp, m + 1);
@@ -94,6 +97,7 @@ int lcs_space_optimized(char *str1, char *str2, int m, int n) {
     int *prev = calloc(m + 1, sizeof(int));
     int *curr = calloc(m + 1, sizeof(int));
     
+    PERF_REGION_BEGIN("lcs_space_optimized_fill");
     for (int j = 1; j <= n; j++) {
         for (int i = 1; i <= m; i++) {
             if (str1[i-1] == str2[j-1])
@@ -107,6 +111,7 @@ int lcs_space_optimized(char *str1, char *str2, int m, int n) {
         prev = curr;
         curr = temp;
     }
+    PERF_REGION_END();
     
     int result = prev[m];
     free(prev);
@@ -350,12 +355,17 @@ void compare_lcs_algorithms(char *str1, char *str2) {
     end = clock();
     double time_optimized = ((double)(end - start)) / CLOCKS_PER_SEC;
     printf("Space Optimized: Length = %d, Time = %f seconds\n", result_optimized, time_optimized);
+    
+    // Counters of the DP fills above, when built with -DPERF_COUNTERS
+    perf_counters_report(stdout);
+    perf_counters_reset();
 }
 
 int main() {
     char str1[1000], str2[1000];
     int choice;
     
+    perf_counters_init();
     while (1) {
         printf("\n=== Longest Common Subsequence (LCS) ===\n");
         printf("1. Calculate LCS length (DP)\n");
@@ -2,15 +2,179 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <aio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include "../PerfCounters/perf_counters.h"
+#include "../SortingNetwork/sorting_network.h"
 
-void merge(int arr[], int left, int mid, int right) {
+#define PARALLEL_CUTOFF 8192  // Ranges below this size are sorted/merged sequentially
+#define MAX_THREADS 256
+#define PRINT_LIMIT 100       // Arrays longer than this are printed truncated
+#define MIN_IO_BLOCK 1024     // Smallest external sort I/O block, in records
+#define MIN_MERGE 64          // Adaptive sort: shorter arrays are insertion sorted
+#define MIN_GALLOP 7          // Adaptive sort: wins in a row before galloping
+#define MAX_RUN_STACK 85      // Adaptive sort: pending runs, enough for 2^64 elements
+
+// Operation counters for SortBenchmark. With -DSORT_STATS every key
+// comparison and swap made by the sequential sorts is counted in globals
+// that the harness defines; otherwise the hooks compile to nothing.
+#ifdef SORT_STATS
+extern long long sort_comparisons;
+extern long long sort_swaps;
+#define COUNT_COMPARISON() (sort_comparisons++)
+#define COUNT_SWAP() (sort_swaps++)
+#else
+#define COUNT_COMPARISON() ((void)0)
+#define COUNT_SWAP() ((void)0)
+#endif
+
+// Number of malloc calls made by the sorting routines, for benchmarking
+long long allocation_count = 0;
+
+void *counted_malloc(size_t bytes) {
+    allocation_count++;
+    return malloc(bytes);
+}
+
+// Merge sort engine specialized at compile time for any element type.
+// DEFINE_MERGE_SORT(name, type, less, network) expands to
+//   void name##_merge(type src[], type dst[], int left, int mid, int right);
+//   void name##_with_buffer(type arr[], type buffer[], int left, int right);
+//   void name(type arr[], int left, int right);        // recursive
+//   void name##_iterative_with_buffer(type arr[], type buffer[], int n);
+//   void name##_iterative(type arr[], int n);           // bottom-up
+// with the comparison macro less(a, b) inlined. Merging takes from the left
+// run unless the right element is strictly smaller, so the sort is stable.
+//
+// Merges never allocate: they read runs from one array and write the result
+// to the other, and each level of the sort swaps the roles of the array and
+// a scratch buffer (ping-pong), so no level copies its result back. The
+// _with_buffer variants take a caller-owned scratch buffer with room for
+// the same indices as arr; the others allocate one buffer per sort.
+//
+// With network = int_network (see SortingNetwork/), ranges of up to
+// SORT_NETWORK_MAX keys are sorted by a SIMD sorting network instead of
+// being split down to single elements, and merges use the vectorized
+// bitonic merge. Only valid for ascending ints, where stability is moot;
+// other instances pass no_network.
+#define DEFINE_MERGE_SORT(name, type, less, network)                           \
+void name##_merge(type src[], type dst[], int left, int mid, int right) {      \
+    PERF_REGION_BEGIN(#name "_merge");                                         \
+    int i = left;    /* Index into the left run src[left..mid] */             \
+    int j = mid + 1; /* Index into the right run src[mid+1..right] */         \
+    int k = left;    /* Index into dst[left..right] */                        \
+                                                                               \
+    if (!network##_merge(src, dst, left, mid, right)) {                        \
+        while (i <= mid && j <= right) {                                       \
+            if (!less(src[j], src[i]))                                         \
+                dst[k++] = src[i++];                                           \
+            else                                                               \
+                dst[k++] = src[j++];                                           \
+        }                                                                      \
+                                                                               \
+        /* Copy the remaining elements of either run, if any */               \
+        while (i <= mid)                                                       \
+            dst[k++] = src[i++];                                               \
+        while (j <= right)                                                     \
+            dst[k++] = src[j++];                                               \
+    }                                                                          \
+    PERF_REGION_END();                                                         \
+}                                                                              \
+                                                                               \
+/* Sort src[left..right] into dst[left..right]. Both arrays hold the same */  \
+/* data on entry; each half is sorted into src, then merged into dst. */      \
+void name##_split_merge(type src[], type dst[], int left, int right) {         \
+    if (left >= right || network##_sort(dst + left, right - left + 1))         \
+        return;                                                                \
+                                                                               \
+    int mid = left + (right - left) / 2;                                       \
+    name##_split_merge(dst, src, left, mid);                                   \
+    name##_split_merge(dst, src, mid + 1, right);                              \
+    name##_merge(src, dst, left, mid, right);                                  \
+}                                                                              \
+                                                                               \
+void name##_with_buffer(type arr[], type buffer[], int left, int right) {      \
+    if (left >= right)                                                         \
+        return;                                                                \
+                                                                               \
+    memcpy(buffer + left, arr + left, (right - left + 1) * sizeof(type));      \
+    name##_split_merge(buffer, arr, left, right);                              \
+}                                                                              \
+                                                                               \
+void name(type arr[], int left, int right) {                                   \
+    if (left >= right)                                                         \
+        return;                                                                \
+                                                                               \
+    type *buffer = counted_malloc((right + 1) * sizeof(type));                 \
+    if (!buffer) {                                                             \
+        printf("Memory allocation failed!\n");                                 \
+        exit(1);                                                               \
+    }                                                                          \
+    name##_with_buffer(arr, buffer, left, right);                              \
+    free(buffer);                                                              \
+}                                                                              \
+                                                                               \
+void name##_iterative_with_buffer(type arr[], type buffer[], int n) {          \
+    type *src = arr, *dst = buffer;                                            \
+    int first_size = 1;                                                        \
+                                                                               \
+    /* Start from blocks sorted by the network, if it takes the first one */  \
+    int block = (n < SORT_NETWORK_MAX) ? n : SORT_NETWORK_MAX;                 \
+    if (n > 1 && network##_sort(arr, block)) {                                 \
+        for (int lo = block; lo < n; lo += block)                              \
+            (void)network##_sort(arr + lo, (n - lo < block) ? n - lo : block); \
+        first_size = block;                                                    \
+    }                                                                          \
+                                                                               \
+    /* Merge runs of curr_size from src into dst, then swap roles */          \
+    for (int curr_size = first_size; curr_size <= n - 1; curr_size *= 2) {     \
+        for (int left_start = 0; left_start < n; left_start += 2 * curr_size) { \
+            int mid = (left_start + curr_size - 1 < n - 1) ?                   \
+                      left_start + curr_size - 1 : n - 1;                      \
+            int right_end = (left_start + 2 * curr_size - 1 < n - 1) ?         \
+                            left_start + 2 * curr_size - 1 : n - 1;            \
+                                                                               \
+            /* A lone trailing run is merged with nothing, i.e. copied */     \
+            name##_merge(src, dst, left_start, mid, right_end);                \
+        }                                                                      \
+        type *swap_ptr = src;                                                  \
+        src = dst;                                                             \
+        dst = swap_ptr;                                                        \
+    }                                                                          \
+                                                                               \
+    /* After an odd number of passes the sorted data sits in the buffer */    \
+    if (src != arr)                                                            \
+        memcpy(arr, src, n * sizeof(type));                                    \
+}                                                                              \
+                                                                               \
+void name##_iterative(type arr[], int n) {                                     \
+    if (n < 2)                                                                 \
+        return;                                                                \
+                                                                               \
+    type *buffer = counted_malloc(n * sizeof(type));                           \
+    if (!buffer) {                                                             \
+        printf("Memory allocation failed!\n");                                 \
+        exit(1);                                                               \
+    }                                                                          \
+    name##_iterative_with_buffer(arr, buffer, n);                              \
+    free(buffer);                                                              \
+}
+
+// Merge with two temporary arrays allocated per call: the previous
+// implementation, kept as the baseline for the allocation benchmark
+void merge_allocating(int arr[], int left, int mid, int right) {
     int i, j, k;
     int n1 = mid - left + 1;
     int n2 = right - mid;
     
     // Create temporary arrays
-    int *L = malloc(n1 * sizeof(int));
-    int *R = malloc(n2 * sizeof(int));
+    int *L = counted_malloc(n1 * sizeof(int));
+    int *R = counted_malloc(n2 * sizeof(int));
     
     if (!L || !R) {
         printf("Memory allocation failed!\n");
@@ -24,9 +188,9 @@ void merge(int arr[], int left, int mid, int right) {
         R[j] = arr[mid + 1 + j];
     
     // Merge the temporary arrays back into arr[left..right]
-    i = 0; // Initial index of first subarray
-    j = 0; // Initial index of second subarray
-    k = left; // Initial index of merged subarray
+    i = 0;
+    j = 0;
+    k = left;
     
     while (i < n1 && j < n2) {
         if (L[i] <= R[j]) {
@@ -39,14 +203,12 @@ void merge(int arr[], int left, int mid, int right) {
         k++;
     }
     
-    // Copy the remaining elements of L[], if any
+    // Copy the remaining elements of L[] and R[], if any
     while (i < n1) {
         arr[k] = L[i];
         i++;
         k++;
     }
-    
-    // Copy the remaining elements of R[], if any
     while (j < n2) {
         arr[k] = R[j];
         j++;
@@ -57,66 +219,1356 @@ void merge(int arr[], int left, int mid, int right) {
     free(R);
 }
 
-void merge_sort(int arr[], int left, int right) {
+void merge_sort_allocating(int arr[], int left, int right) {
     if (left < right) {
         int mid = left + (right - left) / 2;
         
-        // Sort first and second halves
-        merge_sort(arr, left, mid);
-        merge_sort(arr, mid + 1, right);
-        
-        // Merge the sorted halves
-        merge(arr, left, mid, right);
+        merge_sort_allocating(arr, left, mid);
+        merge_sort_allocating(arr, mid + 1, right);
+        merge_allocating(arr, left, mid, right);
     }
 }
 
-// Iterative Merge Sort
-void merge_sort_iterative(int arr[], int n) {
-    int curr_size; // Current size of subarrays to be merged
-    int left_start; // Starting index of left sub-array
-    
-    // Merge subarrays in bottom-up manner
-    for (curr_size = 1; curr_size <= n - 1; curr_size = 2 * curr_size) {
-        // Pick starting point of left sub array
-        for (left_start = 0; left_start < n - 1; left_start += 2 * curr_size) {
-            // Calculate mid point to break the sub array in two halves
-            int mid = (left_start + curr_size - 1 < n - 1) ? 
+void merge_sort_iterative_allocating(int arr[], int n) {
+    for (int curr_size = 1; curr_size <= n - 1; curr_size = 2 * curr_size) {
+        for (int left_start = 0; left_start < n - 1; left_start += 2 * curr_size) {
+            int mid = (left_start + curr_size - 1 < n - 1) ?
                       left_start + curr_size - 1 : n - 1;
-            
-            // Calculate end point of right sub array
-            int right_end = (left_start + 2 * curr_size - 1 < n - 1) ? 
+            int right_end = (left_start + 2 * curr_size - 1 < n - 1) ?
                            left_start + 2 * curr_size - 1 : n - 1;
             
-            // Merge subarrays if mid is smaller than right_end
             if (mid < right_end)
-                merge(arr, left_start, mid, right_end);
+                merge_allocating(arr, left_start, mid, right_end);
         }
     }
 }
 
-void print_array(int arr[], int size) {
-    for (int i = 0; i < size; i++) {
+// 16-byte record: sort key plus an opaque payload (e.g. a row id)
+typedef struct {
+    long long key;
+    long long payload;
+} KeyPayload;
+
+#define SCALAR_LESS(a, b) (COUNT_COMPARISON(), (a) < (b))
+#define KEY_LESS(a, b) SCALAR_LESS((a).key, (b).key)
+
+// Specializations for common key types. The int one provides merge_sort,
+// merge_sort_iterative and merge_sort_merge. Floats must not contain NaN.
+DEFINE_MERGE_SORT(merge_sort, int, SCALAR_LESS, int_network)
+DEFINE_MERGE_SORT(merge_sort_i64, long long, SCALAR_LESS, no_network)
+DEFINE_MERGE_SORT(merge_sort_float, float, SCALAR_LESS, no_network)
+DEFINE_MERGE_SORT(merge_sort_pair, KeyPayload, KEY_LESS, no_network)
+
+// Comparator in the qsort convention: negative, zero or positive
+typedef int (*compare_function)(const void *a, const void *b);
+
+// Stable bottom-up merge sort with a qsort-compatible interface: count
+// elements of `size` bytes each, ordered by cmp. Runs are merged back and
+// forth between the array and one scratch buffer allocated up front.
+// Prefer a DEFINE_MERGE_SORT specialization on hot paths, which inlines the
+// comparison instead of calling through cmp.
+void merge_sort_generic(void *base, size_t count, size_t size, compare_function cmp) {
+    if (count < 2)
+        return;
+    
+    char *buffer = counted_malloc(count * size);
+    if (!buffer) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    char *src = base, *dst = buffer;
+    for (size_t width = 1; width < count; width *= 2) {
+        for (size_t left = 0; left < count; left += 2 * width) {
+            size_t mid = (left + width < count) ? left + width : count;
+            size_t right = (left + 2 * width < count) ? left + 2 * width : count;
+            size_t i = left, j = mid, k = left;
+            
+            while (i < mid && j < right) {
+                if (cmp(src + j * size, src + i * size) < 0) {
+                    memcpy(dst + k * size, src + j * size, size);
+                    j++;
+                } else {
+                    memcpy(dst + k * size, src + i * size, size);
+                    i++;
+                }
+                k++;
+            }
+            memcpy(dst + k * size, src + i * size, (mid - i) * size);
+            k += mid - i;
+            memcpy(dst + k * size, src + j * size, (right - j) * size);
+        }
+        
+        char *swap_ptr = src;
+        src = dst;
+        dst = swap_ptr;
+    }
+    
+    // After an odd number of passes the sorted data sits in the buffer
+    if (src != base)
+        memcpy(base, src, count * size);
+    free(buffer);
+}
+
+// Minimum run length for an adaptive sort of n elements: n itself when it is
+// below MIN_MERGE, otherwise a value in [MIN_MERGE/2, MIN_MERGE] chosen so
+// that n / min_run is a power of two or slightly below one, which keeps the
+// final merges balanced
+int tim_sort_min_run(int n) {
+    int extra = 0;  // Set if any bit shifted out is 1
+    
+    while (n >= MIN_MERGE) {
+        extra |= n & 1;
+        n >>= 1;
+    }
+    return n + extra;
+}
+
+// Adaptive merge sort in the style of TimSort. Stable, and close to linear on
+// input that is already mostly ordered.
+// DEFINE_TIM_SORT(name, type, less) expands to
+//   void name##_with_buffer(type arr[], type buffer[], int n);
+//   void name(type arr[], int n);
+// plus the helpers below, with the comparison macro less(a, b) inlined.
+//
+// The array is scanned left to right for natural runs: non-descending runs
+// are kept and strictly descending ones are reversed in place (strictly, so
+// equal keys never swap). Runs shorter than tim_sort_min_run(n) are extended
+// with binary insertion sort. Each run is pushed on a stack that is merged
+// while the lengths break the invariants len[k-2] > len[k-1] + len[k] and
+// len[k-1] > len[k], which keeps merges balanced and the stack O(log n) deep.
+//
+// A merge first gallops to skip the prefix of the left run and the suffix
+// of the right run that are already in place, then copies the left run to
+// the scratch buffer and merges back into the array. Once one side wins
+// min_gallop times in a row it switches to galloping (exponential then
+// binary search) and moves whole blocks; the threshold drops while
+// galloping pays off and rises when it does not. The _with_buffer variant
+// takes a caller-owned scratch buffer of n elements.
+#define DEFINE_TIM_SORT(name, type, less)                                      \
+/* Sort arr[lo..hi) given that arr[lo..start) is already sorted. Equal */      \
+/* keys are inserted after the existing ones, so the sort stays stable. */     \
+void name##_binary_insertion_sort(type arr[], int lo, int hi, int start) {     \
+    for (int i = start; i < hi; i++) {                                         \
+        type pivot = arr[i];                                                   \
+        int left = lo, right = i;                                              \
+                                                                               \
+        while (left < right) {                                                 \
+            int mid = left + (right - left) / 2;                               \
+            if (less(pivot, arr[mid]))                                         \
+                right = mid;                                                   \
+            else                                                               \
+                left = mid + 1;                                                \
+        }                                                                      \
+        memmove(arr + left + 1, arr + left, (i - left) * sizeof(type));        \
+        arr[left] = pivot;                                                     \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+/* Length of the natural run starting at arr[lo] within arr[lo..hi). */        \
+/* A strictly descending run is reversed so every run ends up ascending. */    \
+int name##_count_run(type arr[], int lo, int hi) {                             \
+    int end = lo + 1;                                                          \
+                                                                               \
+    if (end == hi)                                                             \
+        return 1;                                                              \
+                                                                               \
+    end++;                                                                     \
+    if (less(arr[lo + 1], arr[lo])) {                                          \
+        while (end < hi && less(arr[end], arr[end - 1]))                       \
+            end++;                                                             \
+        for (int i = lo, j = end - 1; i < j; i++, j--) {                       \
+            COUNT_SWAP();                                                      \
+            type temp = arr[i];                                                \
+            arr[i] = arr[j];                                                   \
+            arr[j] = temp;                                                     \
+        }                                                                      \
+    } else {                                                                   \
+        while (end < hi && !less(arr[end], arr[end - 1]))                      \
+            end++;                                                             \
+    }                                                                          \
+    return end - lo;                                                           \
+}                                                                              \
+                                                                               \
+/* Number of elements of sorted a[0..n) that are strictly less than key, */    \
+/* found by probing a[1], a[3], a[7], ... and then binary search. */           \
+int name##_gallop_left(type key, const type a[], int n) {                      \
+    int last = 0, ofs = 1;                                                     \
+                                                                               \
+    if (!less(a[0], key))                                                      \
+        return 0;                                                              \
+    while (ofs < n && less(a[ofs], key)) {                                     \
+        last = ofs;                                                            \
+        ofs = 2 * ofs + 1;                                                     \
+    }                                                                          \
+    if (ofs > n)                                                               \
+        ofs = n;                                                               \
+                                                                               \
+    /* a[last] < key <= a[ofs] (or ofs == n) */                                \
+    last++;                                                                    \
+    while (last < ofs) {                                                       \
+        int mid = last + (ofs - last) / 2;                                     \
+        if (less(a[mid], key))                                                 \
+            last = mid + 1;                                                    \
+        else                                                                   \
+            ofs = mid;                                                         \
+    }                                                                          \
+    return ofs;                                                                \
+}                                                                              \
+                                                                               \
+/* Number of elements of sorted a[0..n) that are less than or equal to key */  \
+int name##_gallop_right(type key, const type a[], int n) {                     \
+    int last = 0, ofs = 1;                                                     \
+                                                                               \
+    if (less(key, a[0]))                                                       \
+        return 0;                                                              \
+    while (ofs < n && !less(key, a[ofs])) {                                    \
+        last = ofs;                                                            \
+        ofs = 2 * ofs + 1;                                                     \
+    }                                                                          \
+    if (ofs > n)                                                               \
+        ofs = n;                                                               \
+                                                                               \
+    /* a[last] <= key < a[ofs] (or ofs == n) */                                \
+    last++;                                                                    \
+    while (last < ofs) {                                                       \
+        int mid = last + (ofs - last) / 2;                                     \
+        if (less(key, a[mid]))                                                 \
+            ofs = mid;                                                         \
+        else                                                                   \
+            last = mid + 1;                                                    \
+    }                                                                          \
+    return ofs;                                                                \
+}                                                                              \
+                                                                               \
+/* Merge the adjacent sorted runs arr[base..base+len1) and the len2 */         \
+/* elements after it. Left-run elements win ties. */                           \
+void name##_merge_runs(type arr[], type buffer[], int base, int len1, int len2) { \
+    /* Left-run elements <= the first right element are already in place */    \
+    int skip = name##_gallop_right(arr[base + len1], arr + base, len1);        \
+    base += skip;                                                              \
+    len1 -= skip;                                                              \
+    if (len1 == 0)                                                             \
+        return;                                                                \
+                                                                               \
+    /* So are right-run elements >= the last left element */                   \
+    len2 = name##_gallop_left(arr[base + len1 - 1], arr + base + len1, len2);  \
+    if (len2 == 0)                                                             \
+        return;                                                                \
+                                                                               \
+    memcpy(buffer, arr + base, len1 * sizeof(type));                           \
+    type *a = buffer;           /* Left run, moved out of the way */           \
+    type *b = arr + base + len1; /* Right run, read in place */                \
+    type *dst = arr + base;     /* Never overtakes b: d = i + j < len1 + j */  \
+    int i = 0, j = 0, d = 0;                                                   \
+    int min_gallop = MIN_GALLOP;                                               \
+                                                                               \
+    while (i < len1 && j < len2) {                                             \
+        int wins_a = 0, wins_b = 0;                                            \
+                                                                               \
+        /* One element at a time until one side keeps winning */               \
+        while (i < len1 && j < len2) {                                         \
+            if (less(b[j], a[i])) {                                            \
+                dst[d++] = b[j++];                                             \
+                wins_a = 0;                                                    \
+                if (++wins_b >= min_gallop)                                    \
+                    break;                                                     \
+            } else {                                                           \
+                dst[d++] = a[i++];                                             \
+                wins_b = 0;                                                    \
+                if (++wins_a >= min_gallop)                                    \
+                    break;                                                     \
+            }                                                                  \
+        }                                                                      \
+        if (i == len1 || j == len2)                                            \
+            break;                                                             \
+                                                                               \
+        /* Galloping: move whole blocks while they stay long */                \
+        do {                                                                   \
+            wins_a = name##_gallop_right(b[j], a + i, len1 - i);               \
+            memcpy(dst + d, a + i, wins_a * sizeof(type));                     \
+            d += wins_a;                                                       \
+            i += wins_a;                                                       \
+            if (i == len1)                                                     \
+                break;                                                         \
+            dst[d++] = b[j++];                                                 \
+            if (j == len2)                                                     \
+                break;                                                         \
+                                                                               \
+            wins_b = name##_gallop_left(a[i], b + j, len2 - j);                \
+            memmove(dst + d, b + j, wins_b * sizeof(type));                    \
+            d += wins_b;                                                       \
+            j += wins_b;                                                       \
+            if (j == len2)                                                     \
+                break;                                                         \
+            dst[d++] = a[i++];                                                 \
+            if (i == len1)                                                     \
+                break;                                                         \
+                                                                               \
+            if (min_gallop > 1)                                                \
+                min_gallop--;                                                  \
+        } while (wins_a >= MIN_GALLOP || wins_b >= MIN_GALLOP);                \
+        min_gallop += 2; /* Penalize leaving galloping mode */                 \
+    }                                                                          \
+                                                                               \
+    /* What is left of the right run is already in place */                    \
+    memcpy(dst + d, a + i, (len1 - i) * sizeof(type));                         \
+}                                                                              \
+                                                                               \
+/* Merge stack runs k and k + 1; returns the new stack size */                 \
+int name##_merge_at(type arr[], type buffer[], int run_base[], int run_len[],  \
+                    int stack_size, int k) {                                   \
+    PERF_REGION_BEGIN(#name "_merge");                                         \
+    name##_merge_runs(arr, buffer, run_base[k], run_len[k], run_len[k + 1]);   \
+    run_len[k] += run_len[k + 1];                                              \
+    if (k == stack_size - 3) {                                                 \
+        run_base[k + 1] = run_base[k + 2];                                     \
+        run_len[k + 1] = run_len[k + 2];                                       \
+    }                                                                          \
+    PERF_REGION_END();                                                         \
+    return stack_size - 1;                                                     \
+}                                                                              \
+                                                                               \
+void name##_with_buffer(type arr[], type buffer[], int n) {                    \
+    int run_base[MAX_RUN_STACK], run_len[MAX_RUN_STACK];                       \
+    int stack_size = 0;                                                        \
+    int min_run = tim_sort_min_run(n);                                         \
+                                                                               \
+    if (n < 2)                                                                 \
+        return;                                                                \
+                                                                               \
+    for (int lo = 0; lo < n; ) {                                               \
+        int len = name##_count_run(arr, lo, n);                                \
+        if (len < min_run) {                                                   \
+            int forced = (n - lo < min_run) ? n - lo : min_run;                \
+            name##_binary_insertion_sort(arr, lo, lo + forced, lo + len);      \
+            len = forced;                                                      \
+        }                                                                      \
+        run_base[stack_size] = lo;                                             \
+        run_len[stack_size] = len;                                             \
+        stack_size++;                                                          \
+        lo += len;                                                             \
+                                                                               \
+        /* Restore the invariants on the top three runs */                     \
+        while (stack_size > 1) {                                               \
+            int k = stack_size - 2;                                            \
+            if ((k > 0 && run_len[k - 1] <= run_len[k] + run_len[k + 1]) ||    \
+                (k > 1 && run_len[k - 2] <= run_len[k - 1] + run_len[k])) {    \
+                if (run_len[k - 1] < run_len[k + 1])                           \
+                    k--;                                                       \
+            } else if (run_len[k] > run_len[k + 1]) {                          \
+                break;                                                         \
+            }                                                                  \
+            stack_size = name##_merge_at(arr, buffer, run_base, run_len,       \
+                                         stack_size, k);                       \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* Merge whatever is left, smaller neighbours first */                     \
+    while (stack_size > 1) {                                                   \
+        int k = stack_size - 2;                                                \
+        if (k > 0 && run_len[k - 1] < run_len[k + 1])                          \
+            k--;                                                               \
+        stack_size = name##_merge_at(arr, buffer, run_base, run_len,           \
+                                     stack_size, k);                           \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name(type arr[], int n) {                                                 \
+    if (n < 2)                                                                 \
+        return;                                                                \
+                                                                               \
+    type *buffer = counted_malloc(n * sizeof(type));                           \
+    if (!buffer) {                                                             \
+        printf("Memory allocation failed!\n");                                 \
+        exit(1);                                                               \
+    }                                                                          \
+    name##_with_buffer(arr, buffer, n);                                        \
+    free(buffer);                                                              \
+}
+
+DEFINE_TIM_SORT(tim_sort, int, SCALAR_LESS)
+DEFINE_TIM_SORT(tim_sort_pair, KeyPayload, KEY_LESS)
+
+// Parallel merge sort built on a DEFINE_MERGE_SORT specialization `base`.
+// DEFINE_PARALLEL_MERGE_SORT(name, base, type, less) expands to
+//   void name(type arr[], int n, int num_threads);
+// The two halves are sorted as separate tasks (one on a new thread, one on
+// the calling thread), splitting the thread budget between them. The merge
+// is parallel too: the output is cut into num_threads equal segments, and
+// binary-search co-ranking finds for each cut how many elements come from
+// each run, so every segment merges independently. Ties are resolved
+// towards the left run everywhere, so the result is stable and identical
+// to base().
+#define DEFINE_PARALLEL_MERGE_SORT(name, base, type, less)                     \
+typedef struct {                                                               \
+    type *src;                                                                 \
+    type *dst;                                                                 \
+    int left;                                                                  \
+    int right;                                                                 \
+    int mid;                                                                   \
+    int out_begin;                                                             \
+    int out_end;                                                               \
+    int threads;                                                               \
+} name##_Task;                                                                 \
+                                                                               \
+/* Number of elements of a[0..na) among the first k merged outputs of a, b */ \
+int name##_co_rank(int k, const type a[], int na, const type b[], int nb) {    \
+    int lo = (k - nb > 0) ? k - nb : 0;                                        \
+    int hi = (k < na) ? k : na;                                                \
+                                                                               \
+    /* Smallest i where a[i] does not belong before b[k-i-1] */               \
+    while (lo < hi) {                                                          \
+        int i = lo + (hi - lo) / 2;                                            \
+        if (!less(b[k - i - 1], a[i]))                                         \
+            lo = i + 1;                                                        \
+        else                                                                   \
+            hi = i;                                                            \
+    }                                                                          \
+    return lo;                                                                 \
+}                                                                              \
+                                                                               \
+/* Merge output positions [out_begin, out_end) of runs src[left..mid] and */  \
+/* src[mid+1..right] into dst */                                              \
+void *name##_merge_segment(void *arg) {                                        \
+    name##_Task *task = arg;                                                   \
+    type *a = task->src + task->left;                                          \
+    type *b = task->src + task->mid + 1;                                       \
+    int na = task->mid - task->left + 1;                                       \
+    int nb = task->right - task->mid;                                          \
+    int i = name##_co_rank(task->out_begin, a, na, b, nb);                     \
+    int j = task->out_begin - i;                                               \
+    int i_end = name##_co_rank(task->out_end, a, na, b, nb);                   \
+    int j_end = task->out_end - i_end;                                         \
+    type *out = task->dst + task->left + task->out_begin;                      \
+                                                                               \
+    while (i < i_end && j < j_end) {                                           \
+        if (!less(b[j], a[i]))                                                 \
+            *out++ = a[i++];                                                   \
+        else                                                                   \
+            *out++ = b[j++];                                                   \
+    }                                                                          \
+    while (i < i_end)                                                          \
+        *out++ = a[i++];                                                       \
+    while (j < j_end)                                                          \
+        *out++ = b[j++];                                                       \
+    return NULL;                                                               \
+}                                                                              \
+                                                                               \
+void name##_parallel_merge(type src[], type dst[], int left, int mid,          \
+                           int right, int threads) {                           \
+    int total = right - left + 1;                                              \
+    name##_Task tasks[MAX_THREADS];                                            \
+    pthread_t workers[MAX_THREADS];                                            \
+                                                                               \
+    if (threads > total / PARALLEL_CUTOFF)                                     \
+        threads = total / PARALLEL_CUTOFF;                                     \
+    if (threads <= 1) {                                                        \
+        base##_merge(src, dst, left, mid, right);                              \
+        return;                                                                \
+    }                                                                          \
+                                                                               \
+    for (int t = 0; t < threads; t++) {                                        \
+        tasks[t].src = src;                                                    \
+        tasks[t].dst = dst;                                                    \
+        tasks[t].left = left;                                                  \
+        tasks[t].mid = mid;                                                    \
+        tasks[t].right = right;                                                \
+        tasks[t].out_begin = (int)((long long)total * t / threads);            \
+        tasks[t].out_end = (int)((long long)total * (t + 1) / threads);        \
+        if (t > 0)                                                             \
+            pthread_create(&workers[t], NULL, name##_merge_segment, &tasks[t]); \
+    }                                                                          \
+    name##_merge_segment(&tasks[0]);                                           \
+    for (int t = 1; t < threads; t++)                                          \
+        pthread_join(workers[t], NULL);                                        \
+}                                                                              \
+                                                                               \
+/* Parallel version of base##_split_merge: sort src[left..right] into dst */  \
+void *name##_split_merge(void *arg) {                                          \
+    name##_Task *task = arg;                                                   \
+    int left = task->left, right = task->right;                                \
+                                                                               \
+    if (task->threads <= 1 || right - left + 1 < PARALLEL_CUTOFF) {            \
+        base##_split_merge(task->src, task->dst, left, right);                 \
+        return NULL;                                                           \
+    }                                                                          \
+                                                                               \
+    int mid = left + (right - left) / 2;                                       \
+    int left_threads = task->threads / 2;                                      \
+    name##_Task halves[2] = {                                                  \
+        {task->dst, task->src, left, mid, 0, 0, 0, left_threads},              \
+        {task->dst, task->src, mid + 1, right, 0, 0, 0,                        \
+         task->threads - left_threads}                                         \
+    };                                                                         \
+    pthread_t worker;                                                          \
+                                                                               \
+    pthread_create(&worker, NULL, name##_split_merge, &halves[0]);             \
+    name##_split_merge(&halves[1]);                                            \
+    pthread_join(worker, NULL);                                                \
+                                                                               \
+    name##_parallel_merge(task->src, task->dst, left, mid, right,              \
+                          task->threads);                                      \
+    return NULL;                                                               \
+}                                                                              \
+                                                                               \
+void name(type arr[], int n, int num_threads) {                                \
+    if (num_threads < 1)                                                       \
+        num_threads = 1;                                                       \
+    if (num_threads > MAX_THREADS)                                             \
+        num_threads = MAX_THREADS;                                             \
+    if (n < 2)                                                                 \
+        return;                                                                \
+                                                                               \
+    type *buffer = counted_malloc(n * sizeof(type));                           \
+    if (!buffer) {                                                             \
+        printf("Memory allocation failed!\n");                                 \
+        exit(1);                                                               \
+    }                                                                          \
+    memcpy(buffer, arr, n * sizeof(type));                                     \
+                                                                               \
+    name##_Task root = {buffer, arr, 0, n - 1, 0, 0, 0, num_threads};          \
+    name##_split_merge(&root);                                                 \
+    free(buffer);                                                              \
+}
+
+DEFINE_PARALLEL_MERGE_SORT(merge_sort_parallel, merge_sort, int, SCALAR_LESS)
+DEFINE_PARALLEL_MERGE_SORT(merge_sort_pair_parallel, merge_sort_pair, KeyPayload, KEY_LESS)
+
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ---------------------------------------------------------------------
+// External merge sort for binary files of native int64 records.
+//
+// Phase 1 reads the input in memory-sized chunks, sorts each with
+// merge_sort_i64_iterative_with_buffer and spills it to a temporary run
+// file; the next chunk is read asynchronously while the current one sorts.
+// Phase 2 merges up to fan_in runs at a time through a loser tree, repeating
+// until one pass can write the output. Every run is read through two
+// buffers: while the merge consumes one, an asynchronous read fills the
+// other. The output is written the same way.
+// ---------------------------------------------------------------------
+
+typedef struct {
+    size_t memory_budget; // Bytes of record buffers to use at most
+    int fan_in;           // Runs merged per pass
+    const char *temp_dir; // Where run files are created
+} ExternalSortConfig;
+
+// Double-buffered sequential reader of int64 records
+typedef struct {
+    int fd;
+    off_t next_offset;     // File offset of the next read to issue
+    long long *buffers[2];
+    size_t counts[2];      // Records in each buffer
+    size_t block;          // Capacity of each buffer, in records
+    int current;           // Buffer being consumed
+    size_t pos;            // Next record in the current buffer
+    struct aiocb request;  // Read in flight into the other buffer
+    int pending;
+} RunReader;
+
+// Double-buffered sequential writer of int64 records
+typedef struct {
+    int fd;
+    off_t next_offset;
+    long long *buffers[2];
+    size_t block;
+    int current;
+    size_t fill;           // Records in the current buffer
+    struct aiocb request;  // Write in flight from the other buffer
+    int pending;
+} RunWriter;
+
+// A sorted run spilled to an (already unlinked) temporary file
+typedef struct {
+    int fd;
+    long long count;
+} Run;
+
+int aio_wait(struct aiocb *request, ssize_t *result) {
+    const struct aiocb *list[1] = {request};
+    
+    while (aio_error(request) == EINPROGRESS)
+        aio_suspend(list, 1, NULL);
+    if (aio_error(request) != 0) {
+        errno = aio_error(request);
+        return -1;
+    }
+    *result = aio_return(request);
+    return 0;
+}
+
+void reader_issue(RunReader *reader, int slot) {
+    memset(&reader->request, 0, sizeof(reader->request));
+    reader->request.aio_fildes = reader->fd;
+    reader->request.aio_buf = reader->buffers[slot];
+    reader->request.aio_nbytes = reader->block * sizeof(long long);
+    reader->request.aio_offset = reader->next_offset;
+    if (aio_read(&reader->request) != 0) {
+        perror("aio_read");
+        exit(1);
+    }
+    reader->pending = 1;
+}
+
+// Wait for the read in flight, make it current and start the next one
+int reader_swap(RunReader *reader) {
+    ssize_t bytes;
+    int slot = 1 - reader->current;
+    
+    if (!reader->pending)
+        return 0;
+    if (aio_wait(&reader->request, &bytes) != 0) {
+        perror("External sort read failed");
+        exit(1);
+    }
+    reader->pending = 0;
+    if (bytes % sizeof(long long) != 0) {
+        fprintf(stderr, "External sort read failed: partial record at offset %lld\n",
+                (long long)reader->next_offset + bytes / sizeof(long long) * sizeof(long long));
+        exit(1);
+    }
+    reader->counts[slot] = bytes / sizeof(long long);
+    reader->next_offset += bytes;
+    reader->current = slot;
+    reader->pos = 0;
+    
+    if (bytes > 0)
+        reader_issue(reader, 1 - slot);
+    return reader->counts[slot] > 0;
+}
+
+void reader_open(RunReader *reader, int fd, long long *storage, size_t block) {
+    reader->fd = fd;
+    reader->next_offset = 0;
+    reader->buffers[0] = storage;
+    reader->buffers[1] = storage + block;
+    reader->counts[0] = reader->counts[1] = 0;
+    reader->block = block;
+    reader->current = 1;
+    reader->pos = 0;
+    reader_issue(reader, 0);
+}
+
+// Next record into *value; 0 once the run is exhausted
+int reader_next(RunReader *reader, long long *value) {
+    if (reader->pos == reader->counts[reader->current] && !reader_swap(reader))
+        return 0;
+    *value = reader->buffers[reader->current][reader->pos++];
+    return 1;
+}
+
+void writer_wait(RunWriter *writer) {
+    ssize_t bytes;
+    
+    if (!writer->pending)
+        return;
+    if (aio_wait(&writer->request, &bytes) != 0 ||
+        (size_t)bytes != writer->request.aio_nbytes) {
+        perror("External sort write failed");
+        exit(1);
+    }
+    writer->pending = 0;
+}
+
+// Hand the current buffer to an asynchronous write and switch buffers
+void writer_flush(RunWriter *writer) {
+    if (writer->fill == 0)
+        return;
+    writer_wait(writer);
+    
+    memset(&writer->request, 0, sizeof(writer->request));
+    writer->request.aio_fildes = writer->fd;
+    writer->request.aio_buf = writer->buffers[writer->current];
+    writer->request.aio_nbytes = writer->fill * sizeof(long long);
+    writer->request.aio_offset = writer->next_offset;
+    if (aio_write(&writer->request) != 0) {
+        perror("aio_write");
+        exit(1);
+    }
+    writer->pending = 1;
+    writer->next_offset += writer->fill * sizeof(long long);
+    writer->current = 1 - writer->current;
+    writer->fill = 0;
+}
+
+void writer_open(RunWriter *writer, int fd, long long *storage, size_t block) {
+    writer->fd = fd;
+    writer->next_offset = 0;
+    writer->buffers[0] = storage;
+    writer->buffers[1] = storage + block;
+    writer->block = block;
+    writer->current = 0;
+    writer->fill = 0;
+    writer->pending = 0;
+}
+
+void writer_put(RunWriter *writer, long long value) {
+    writer->buffers[writer->current][writer->fill++] = value;
+    if (writer->fill == writer->block)
+        writer_flush(writer);
+}
+
+void writer_close(RunWriter *writer) {
+    writer_flush(writer);
+    writer_wait(writer);
+}
+
+// Create an anonymous run file: the name is unlinked right away, so the
+// space is reclaimed when the descriptor is closed, even on a crash
+int create_run_file(const char *temp_dir) {
+    char path[4096];
+    
+    snprintf(path, sizeof(path), "%s/merge_sort_run_XXXXXX", temp_dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("Cannot create run file");
+        exit(1);
+    }
+    unlink(path);
+    return fd;
+}
+
+int write_all(int fd, const void *data, size_t bytes) {
+    const char *p = data;
+    
+    while (bytes > 0) {
+        ssize_t written = write(fd, p, bytes);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += written;
+        bytes -= written;
+    }
+    return 0;
+}
+
+// Loser tree over k runs. tree[0] holds the current winner, tree[1..k-1]
+// the loser of the match played at each internal node. Index k is a
+// virtual run that beats everything and is only used while building.
+typedef struct {
+    int k;
+    int *tree;
+    long long *keys;  // Current head of each run
+    int *exhausted;
+} LoserTree;
+
+// Run a beats run b: smaller key wins, ties go to the lower run index so
+// records from earlier runs (earlier input) come first
+int loser_tree_beats(LoserTree *lt, int a, int b) {
+    if (a == lt->k)
+        return 1;
+    if (b == lt->k)
+        return 0;
+    if (lt->exhausted[a] != lt->exhausted[b])
+        return lt->exhausted[b];
+    if (lt->exhausted[a])
+        return a < b;
+    if (lt->keys[a] != lt->keys[b])
+        return lt->keys[a] < lt->keys[b];
+    return a < b;
+}
+
+// Replay the matches from leaf s up to the root after its key changed
+void loser_tree_adjust(LoserTree *lt, int s) {
+    for (int t = (s + lt->k) / 2; t > 0; t /= 2) {
+        if (loser_tree_beats(lt, lt->tree[t], s)) {
+            int winner = lt->tree[t];
+            lt->tree[t] = s;
+            s = winner;
+        }
+    }
+    lt->tree[0] = s;
+}
+
+void loser_tree_build(LoserTree *lt) {
+    for (int i = 0; i < lt->k; i++)
+        lt->tree[i] = lt->k;
+    for (int i = lt->k - 1; i >= 0; i--)
+        loser_tree_adjust(lt, i);
+}
+
+// Merge runs[0..k-1] into fd, closing the run files. Returns records written
+void merge_runs(Run runs[], int k, int out_fd, long long *storage, size_t block) {
+    RunReader *readers = malloc(k * sizeof(RunReader));
+    LoserTree lt;
+    RunWriter writer;
+    
+    lt.k = k;
+    lt.tree = malloc(k * sizeof(int));
+    lt.keys = malloc(k * sizeof(long long));
+    lt.exhausted = malloc(k * sizeof(int));
+    if (!readers || !lt.tree || !lt.keys || !lt.exhausted) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    for (int i = 0; i < k; i++) {
+        reader_open(&readers[i], runs[i].fd, storage + 2 * block * i, block);
+        lt.exhausted[i] = !reader_next(&readers[i], &lt.keys[i]);
+    }
+    writer_open(&writer, out_fd, storage + 2 * block * k, block);
+    loser_tree_build(&lt);
+    
+    while (!lt.exhausted[lt.tree[0]]) {
+        int w = lt.tree[0];
+        writer_put(&writer, lt.keys[w]);
+        lt.exhausted[w] = !reader_next(&readers[w], &lt.keys[w]);
+        loser_tree_adjust(&lt, w);
+    }
+    writer_close(&writer);
+    
+    for (int i = 0; i < k; i++)
+        close(runs[i].fd);
+    free(readers);
+    free(lt.tree);
+    free(lt.keys);
+    free(lt.exhausted);
+}
+
+// Sort the int64 records of input_path into output_path. Returns 0 on
+// success, -1 on an unusable configuration or input/output error
+int external_merge_sort(const char *input_path, const char *output_path,
+                        ExternalSortConfig config) {
+    struct stat st;
+    int in_fd = open(input_path, O_RDONLY);
+    if (in_fd < 0 || fstat(in_fd, &st) < 0) {
+        perror(input_path);
+        if (in_fd >= 0)
+            close(in_fd);
+        return -1;
+    }
+    if (st.st_size % sizeof(long long) != 0) {
+        fprintf(stderr, "%s: size %lld is not a whole number of %zu-byte records\n",
+                input_path, (long long)st.st_size, sizeof(long long));
+        close(in_fd);
+        return -1;
+    }
+    
+    // Phase 2 gives each of the fan_in runs and the writer two blocks of at
+    // least MIN_IO_BLOCK records; lower the fan-in to what the budget holds
+    size_t block_pairs = config.memory_budget / (2 * MIN_IO_BLOCK * sizeof(long long));
+    if (config.fan_in < 2 || block_pairs < 3) {
+        fprintf(stderr, "Memory budget must be at least %zu bytes and fan-in at least 2.\n",
+                6 * MIN_IO_BLOCK * sizeof(long long));
+        close(in_fd);
+        return -1;
+    }
+    if ((size_t)config.fan_in > block_pairs - 1) {
+        fprintf(stderr, "Fan-in %d does not fit the memory budget; using %zu.\n",
+                config.fan_in, block_pairs - 1);
+        config.fan_in = (int)(block_pairs - 1);
+    }
+    
+    // Phase 1: two chunks (one sorting, one being read) plus a scratch buffer
+    size_t chunk = config.memory_budget / (3 * sizeof(long long));
+    if (chunk > (size_t)INT_MAX / 2)
+        chunk = (size_t)INT_MAX / 2;
+    
+    long long *storage = malloc(3 * chunk * sizeof(long long));
+    if (!storage) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    int run_capacity = 16, run_count = 0;
+    Run *runs = malloc(run_capacity * sizeof(Run));
+    RunReader input;
+    long long total = 0;
+    
+    if (!runs) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    // The reader's two buffers are the two chunks; reader_swap starts the
+    // read of the next chunk before this one is sorted and spilled
+    reader_open(&input, in_fd, storage, chunk);
+    while (reader_swap(&input)) {
+        long long *data = input.buffers[input.current];
+        int n = (int)input.counts[input.current];
+        
+        merge_sort_i64_iterative_with_buffer(data, storage + 2 * chunk, n);
+        
+        if (run_count == run_capacity) {
+            run_capacity *= 2;
+            runs = realloc(runs, run_capacity * sizeof(Run));
+            if (!runs) {
+                printf("Memory allocation failed!\n");
+                exit(1);
+            }
+        }
+        runs[run_count].fd = create_run_file(config.temp_dir);
+        runs[run_count].count = n;
+        if (write_all(runs[run_count].fd, data, n * sizeof(long long)) != 0) {
+            perror("Cannot write run file");
+            exit(1);
+        }
+        run_count++;
+        total += n;
+    }
+    close(in_fd);
+    int initial_runs = run_count;
+    
+    // Phase 2: merge fan_in runs at a time until one pass reaches the output.
+    // Each run and the writer get two blocks of the budget
+    size_t block = config.memory_budget / (2 * (config.fan_in + 1) * sizeof(long long));
+    free(storage);
+    storage = malloc(2 * block * (config.fan_in + 1) * sizeof(long long));
+    if (!storage) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    int first = 0, passes = 0;
+    while (run_count - first > config.fan_in) {
+        int k = config.fan_in;
+        Run merged = {create_run_file(config.temp_dir), 0};
+        
+        for (int i = 0; i < k; i++)
+            merged.count += runs[first + i].count;
+        merge_runs(runs + first, k, merged.fd, storage, block);
+        first += k;
+        
+        // Append the merged run; earlier slots are no longer needed
+        if (run_count == run_capacity) {
+            memmove(runs, runs + first, (run_count - first) * sizeof(Run));
+            run_count -= first;
+            first = 0;
+        }
+        runs[run_count++] = merged;
+        passes++;
+    }
+    
+    int out_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        perror(output_path);
+        free(storage);
+        free(runs);
+        return -1;
+    }
+    if (run_count > first)
+        merge_runs(runs + first, run_count - first, out_fd, storage, block);
+    close(out_fd);
+    
+    printf("External sort: %lld records, %d initial runs, %d intermediate merges\n",
+           total, initial_runs, passes);
+    
+    free(storage);
+    free(runs);
+    return 0;
+}
+
+// Write `count` random int64 records (with duplicates and negatives) to
+// a file several times larger than the budget, sort it externally and
+// check the output is sorted and holds the same multiset (count and sum)
+int external_sort_self_test(long long count, ExternalSortConfig config) {
+    char input_path[4096], output_path[4096];
+    long long checksum = 0;
+    
+    snprintf(input_path, sizeof(input_path), "%s/merge_sort_test_in_XXXXXX", config.temp_dir);
+    snprintf(output_path, sizeof(output_path), "%s/merge_sort_test_out_XXXXXX", config.temp_dir);
+    int in_fd = mkstemp(input_path);
+    int out_fd = mkstemp(output_path);
+    if (in_fd < 0 || out_fd < 0) {
+        perror("Cannot create test files");
+        if (in_fd >= 0) {
+            close(in_fd);
+            unlink(input_path);
+        }
+        if (out_fd >= 0) {
+            close(out_fd);
+            unlink(output_path);
+        }
+        return -1;
+    }
+    close(out_fd);
+    
+    // Every failure below falls through to the unlinks at the end, so a
+    // full disk does not leave a large test file behind
+    int status = 0;
+    long long block[MIN_IO_BLOCK];
+    for (long long written = 0; written < count && status == 0; ) {
+        int n = (count - written < MIN_IO_BLOCK) ? (int)(count - written) : MIN_IO_BLOCK;
+        for (int i = 0; i < n; i++) {
+            block[i] = ((long long)rand() << 32 ^ rand()) % 1000003 - 500000;
+            checksum += block[i];
+        }
+        if (write_all(in_fd, block, n * sizeof(long long)) != 0) {
+            perror("Cannot write test input");
+            status = -1;
+        }
+        written += n;
+    }
+    close(in_fd);
+    
+    double elapsed = 0.0;
+    if (status == 0) {
+        printf("Sorting %lld records (%lld bytes) with a %zu byte budget, fan-in %d\n",
+               count, count * (long long)sizeof(long long), config.memory_budget, config.fan_in);
+        double start = wall_time();
+        status = external_merge_sort(input_path, output_path, config);
+        elapsed = wall_time() - start;
+    }
+    
+    int ok = (status == 0);
+    if (ok) {
+        RunReader reader;
+        long long *storage = malloc(2 * MIN_IO_BLOCK * sizeof(long long));
+        long long value, previous = 0, seen = 0, sum = 0;
+        int fd = open(output_path, O_RDONLY);
+        
+        if (!storage || fd < 0) {
+            perror("Cannot read test output");
+            ok = 0;
+        } else {
+            reader_open(&reader, fd, storage, MIN_IO_BLOCK);
+            while (reader_next(&reader, &value)) {
+                if (seen > 0 && value < previous)
+                    ok = 0;
+                previous = value;
+                sum += value;
+                seen++;
+            }
+            ok = ok && seen == count && sum == checksum;
+        }
+        if (fd >= 0)
+            close(fd);
+        free(storage);
+    }
+    
+    printf("Self-test %s in %f seconds\n", ok ? "PASSED" : "FAILED", elapsed);
+    unlink(input_path);
+    unlink(output_path);
+    return ok ? 0 : -1;
+}
+
+// SortBenchmark builds this file with -DSORT_NO_MAIN and calls the sorts
+// itself; the menu, its helpers and the benchmarks below are left out
+#ifndef SORT_NO_MAIN
+
+static int default_thread_count(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+}
+
+static void print_array(int arr[], int size) {
+    int shown = (size > PRINT_LIMIT) ? PRINT_LIMIT : size;
+    for (int i = 0; i < shown; i++) {
         printf("%d ", arr[i]);
     }
+    if (shown < size) {
+        printf("... (%d more)", size - shown);
+    }
     printf("\n");
 }
 
-void copy_array(int source[], int dest[], int size) {
+static void copy_array(int source[], int dest[], int size) {
     for (int i = 0; i < size; i++) {
         dest[i] = source[i];
     }
 }
 
 // Function to generate random array for testing
-void generate_random_array(int arr[], int size, int max_val) {
+static void generate_random_array(int arr[], int size, int max_val) {
     for (int i = 0; i < size; i++) {
         arr[i] = rand() % max_val;
     }
 }
 
-int main() {
+static int compare_key_payload(const void *a, const void *b) {
+    long long ka = ((const KeyPayload *)a)->key;
+    long long kb = ((const KeyPayload *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Records are sorted by key, and equal keys keep ascending payloads
+// (payload = original position), i.e. the sort was stable
+int records_sorted_stable(KeyPayload records[], int size) {
+    for (int i = 1; i < size; i++) {
+        if (records[i - 1].key > records[i].key)
+            return 0;
+        if (records[i - 1].key == records[i].key &&
+            records[i - 1].payload > records[i].payload)
+            return 0;
+    }
+    return 1;
+}
+
+// Sort 16-byte records keyed by the input values three ways: libc qsort,
+// the comparator-based merge_sort_generic and the inlined merge_sort_pair
+static void generic_records_benchmark(int arr[], int size) {
+    const char *names[] = {"libc qsort", "merge_sort_generic", "merge_sort_pair"};
+    KeyPayload *source = malloc(size * sizeof(KeyPayload));
+    KeyPayload *records = malloc(size * sizeof(KeyPayload));
+    
+    if (!source || !records) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < size; i++) {
+        source[i].key = arr[i];
+        source[i].payload = i;
+    }
+    
+    printf("\nSorting %d key/payload records (%zu bytes each):\n",
+           size, sizeof(KeyPayload));
+    for (int method = 0; method < 3; method++) {
+        memcpy(records, source, size * sizeof(KeyPayload));
+        clock_t start = clock();
+        if (method == 0)
+            qsort(records, size, sizeof(KeyPayload), compare_key_payload);
+        else if (method == 1)
+            merge_sort_generic(records, size, sizeof(KeyPayload), compare_key_payload);
+        else
+            merge_sort_pair(records, 0, size - 1);
+        clock_t end = clock();
+        
+        printf("%-22s %f seconds  %s\n", names[method],
+               ((double)(end - start)) / CLOCKS_PER_SEC,
+               records_sorted_stable(records, size) ? "stable" : "NOT STABLE");
+    }
+    
+    free(source);
+    free(records);
+}
+
+// Time and count allocations of the scratch-buffer sorts against the
+// previous per-merge malloc implementation on the same input
+void allocation_benchmark(int arr[], int temp[], int size) {
+    const char *names[] = {
+        "Recursive (per-merge malloc)",
+        "Recursive (scratch buffer)",
+        "Iterative (per-merge malloc)",
+        "Iterative (scratch buffer)"
+    };
+    
+    printf("\n%-30s %12s %14s\n", "Method", "Seconds", "Allocations");
+    for (int method = 0; method < 4; method++) {
+        copy_array(arr, temp, size);
+        allocation_count = 0;
+        
+        clock_t start = clock();
+        switch (method) {
+            case 0: merge_sort_allocating(temp, 0, size - 1); break;
+            case 1: merge_sort(temp, 0, size - 1); break;
+            case 2: merge_sort_iterative_allocating(temp, size); break;
+            default: merge_sort_iterative(temp, size); break;
+        }
+        clock_t end = clock();
+        
+        printf("%-30s %12f %14lld\n", names[method],
+               ((double)(end - start)) / CLOCKS_PER_SEC, allocation_count);
+    }
+}
+
+// Run the parallel sorts with 1, 2, 4, ... threads up to max_threads on
+// ints and on key/payload records (payload = original position), checking
+// that the records come out identical to the sequential merge_sort_pair.
+// Wall-clock time is used since clock() adds up CPU time of all threads
+void parallel_benchmark(int arr[], int temp[], int size, int max_threads) {
+    KeyPayload *source = malloc(size * sizeof(KeyPayload));
+    KeyPayload *expected = malloc(size * sizeof(KeyPayload));
+    KeyPayload *records = malloc(size * sizeof(KeyPayload));
+    double base_time = 0.0;
+    
+    if (!source || !expected || !records) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < size; i++) {
+        source[i].key = arr[i];
+        source[i].payload = i;
+    }
+    memcpy(expected, source, size * sizeof(KeyPayload));
+    merge_sort_pair(expected, 0, size - 1);
+    
+    printf("\nParallel merge sort (%d elements):\n", size);
+    printf("%8s %12s %9s %14s  %s\n", "Threads", "Int seconds", "Speedup",
+           "Pair seconds", "Pairs vs merge_sort");
+    
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads)
+            threads = max_threads;
+        
+        copy_array(arr, temp, size);
+        double start = wall_time();
+        merge_sort_parallel(temp, size, threads);
+        double int_time = wall_time() - start;
+        
+        memcpy(records, source, size * sizeof(KeyPayload));
+        start = wall_time();
+        merge_sort_pair_parallel(records, size, threads);
+        double pair_time = wall_time() - start;
+        
+        if (threads == 1)
+            base_time = int_time;
+        printf("%8d %12f %8.2fx %14f  %s\n", threads, int_time,
+               int_time > 0.0 ? base_time / int_time : 0.0, pair_time,
+               memcmp(records, expected, size * sizeof(KeyPayload)) == 0 ?
+               "identical (stable)" : "MISMATCH");
+        
+        if (threads == max_threads)
+            break;
+    }
+    
+    free(source);
+    free(expected);
+    free(records);
+}
+
+// Shape sorted[0..size) into one presortedness level. Levels 0-4 start from
+// sorted data: as is, with 0.1% or 1% random swaps, or with the last 1% or
+// 10% overwritten by random appends. Level 5 is reversed, 6 is the input.
+void make_presorted(int arr[], int sorted[], int out[], int size, int level) {
+    int swaps = (level == 1) ? size / 1000 : (level == 2) ? size / 100 : 0;
+    int tail = (level == 3) ? size / 100 : (level == 4) ? size / 10 : 0;
+    
+    if (level == 6) {
+        copy_array(arr, out, size);
+        return;
+    }
+    for (int i = 0; i < size; i++)
+        out[i] = (level == 5) ? sorted[size - 1 - i] : sorted[i];
+    for (int s = 0; s < swaps; s++) {
+        int i = rand() % size, j = rand() % size;
+        int temp = out[i];
+        out[i] = out[j];
+        out[j] = temp;
+    }
+    for (int i = size - tail; i < size; i++)
+        out[i] = arr[rand() % size];
+}
+
+void adaptive_benchmark(int arr[], int temp[], int size) {
+    const char *names[] = {
+        "Sorted",
+        "Sorted, 0.1% swaps",
+        "Sorted, 1% swaps",
+        "Sorted + 1% appended",
+        "Sorted + 10% appended",
+        "Reversed",
+        "Input"
+    };
+    int *sorted = malloc(size * sizeof(int));
+    int *input = malloc(size * sizeof(int));
+    int *reference = malloc(size * sizeof(int));
+    KeyPayload *records = malloc(size * sizeof(KeyPayload));
+    KeyPayload *expected = malloc(size * sizeof(KeyPayload));
+    
+    if (!sorted || !input || !reference || !records || !expected) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    copy_array(arr, sorted, size);
+    merge_sort_iterative(sorted, size);
+    
+    printf("\nAdaptive merge sort (%d elements):\n", size);
+    printf("%-24s %14s %12s %9s  %s\n", "Input", "Iterative (s)", "TimSort (s)",
+           "Speedup", "Result");
+    for (int level = 0; level < 7; level++) {
+        make_presorted(arr, sorted, input, size, level);
+        
+        copy_array(input, temp, size);
+        clock_t start = clock();
+        merge_sort_iterative(temp, size);
+        double iterative_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        copy_array(temp, reference, size);
+        
+        copy_array(input, temp, size);
+        start = clock();
+        tim_sort(temp, size);
+        double tim_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        
+        printf("%-24s %14f %12f %8.2fx  %s\n", names[level], iterative_time,
+               tim_time, tim_time > 0.0 ? iterative_time / tim_time : 0.0,
+               memcmp(temp, reference, size * sizeof(int)) == 0 ? "ok" : "MISMATCH");
+        
+        // Both sorts are stable, so records with row ids must agree exactly
+        for (int i = 0; i < size; i++) {
+            records[i].key = input[i];
+            records[i].payload = i;
+        }
+        memcpy(expected, records, size * sizeof(KeyPayload));
+        merge_sort_pair_iterative(expected, size);
+        tim_sort_pair(records, size);
+        if (memcmp(records, expected, size * sizeof(KeyPayload)) != 0)
+            printf("%-24s tim_sort_pair is not stable!\n", names[level]);
+    }
+    
+    free(sorted);
+    free(input);
+    free(reference);
+    free(records);
+    free(expected);
+}
+
+void print_external_usage(const char *program) {
+    printf("Usage:\n");
+    printf("  %s                          interactive mode\n", program);
+    printf("  %s --external INPUT OUTPUT [options]\n", program);
+    printf("  %s --external-selftest [options]\n", program);
+    printf("Options (external modes):\n");
+    printf("  --memory MB      record buffer budget in MiB (default 256)\n");
+    printf("  --fan-in K       runs merged per pass (default 64)\n");
+    printf("  --temp-dir DIR   directory for run files (default /tmp)\n");
+    printf("  --records N      self-test size (default 8x the budget)\n");
+}
+
+// Non-interactive external sort modes; returns the process exit status
+int external_main(int argc, char *argv[]) {
+    ExternalSortConfig config = {256u << 20, 64, "/tmp"};
+    const char *paths[2] = {NULL, NULL};
+    long long records = 0;
+    int path_count = 0;
+    int self_test = strcmp(argv[1], "--external-selftest") == 0;
+    
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            config.memory_budget = (size_t)(atof(argv[++i]) * (1 << 20));
+        } else if (strcmp(argv[i], "--fan-in") == 0 && i + 1 < argc) {
+            config.fan_in = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--temp-dir") == 0 && i + 1 < argc) {
+            config.temp_dir = argv[++i];
+        } else if (strcmp(argv[i], "--records") == 0 && i + 1 < argc) {
+            records = atoll(argv[++i]);
+        } else if (argv[i][0] != '-' && path_count < 2) {
+            paths[path_count++] = argv[i];
+        } else {
+            print_external_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (self_test) {
+        if (records <= 0)
+            records = 8 * (long long)(config.memory_budget / sizeof(long long));
+        return external_sort_self_test(records, config) == 0 ? 0 : 1;
+    }
+    if (path_count != 2) {
+        print_external_usage(argv[0]);
+        return 1;
+    }
+    return external_merge_sort(paths[0], paths[1], config) == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
     srand(time(NULL));
     
+    if (argc > 1) {
+        if (strcmp(argv[1], "--external") == 0 || strcmp(argv[1], "--external-selftest") == 0)
+            return external_main(argc, argv);
+        print_external_usage(argv[0]);
+        return 1;
+    }
+    
     int size, choice, input_choice;
     
     printf("Enter array size: ");
@@ -154,9 +1606,23 @@ int main() {
     printf("1. Recursive Merge Sort\n");
     printf("2. Iterative Merge Sort\n");
     printf("3. Compare both methods\n");
-    printf("Enter choice (1-3): ");
+    printf("4. Generic API on 16-byte key/payload records\n");
+    printf("5. Allocation benchmark (scratch buffer vs per-merge malloc)\n");
+    printf("6. Parallel Merge Sort\n");
+    printf("7. Parallel scaling and stability check\n");
+    printf("8. Adaptive (TimSort-style) Merge Sort over presortedness levels\n");
+    printf("Enter choice (1-8): ");
     scanf("%d", &choice);
     
+    int num_threads = default_thread_count();
+    if (choice == 6 || choice == 7) {
+        printf("Enter number of threads (0 = %d online cores): ", num_threads);
+        int requested;
+        scanf("%d", &requested);
+        if (requested > 0)
+            num_threads = requested;
+    }
+    
     clock_t start, end;
     double time1, time2;
     
@@ -209,6 +1675,45 @@ int main() {
             print_array(temp1, size);
             break;
             
+        case 4:
+            generic_records_benchmark(arr, size);
+            break;
+            
+        case 5:
+            allocation_benchmark(arr, temp1, size);
+            break;
+            
+        case 6: {
+            copy_array(arr, temp1, size);
+            double wall_start = wall_time();
+            merge_sort_parallel(temp1, size, num_threads);
+            time1 = wall_time() - wall_start;
+            
+            printf("\nUsing Parallel Merge Sort with %d threads:\n", num_threads);
+            printf("Sorted array: ");
+            print_array(temp1, size);
+            printf("Time taken: %f seconds\n", time1);
+            break;
+        }
+            
+        case 7:
+            parallel_benchmark(arr, temp1, size, num_threads);
+            break;
+            
+        case 8:
+            copy_array(arr, temp1, size);
+            start = clock();
+            tim_sort(temp1, size);
+            end = clock();
+            time1 = ((double)(end - start)) / CLOCKS_PER_SEC;
+            
+            printf("\nUsing Adaptive Merge Sort:\n");
+            printf("Sorted array: ");
+            print_array(temp1, size);
+            printf("Time taken: %f seconds\n", time1);
+            adaptive_benchmark(arr, temp1, size);
+            break;
+            
         default:
             printf("\nInvalid choice! Using recursive merge sort.\n");
             copy_array(arr, temp1, size);
@@ -223,3 +1728,4 @@ int main() {
     free(temp2);
     return 0;
 }
+#endif
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.h"
+
+typedef struct {
+    const char *name;
+    unsigned int type;
+    unsigned long long config;
+} PerfEventSpec;
+
+PerfEventSpec perf_events[PERF_NUM_EVENTS] = {
+    {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"l1d_misses",    PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"llc_misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"task_clock_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+};
+
+// All events that could be opened form one group led by the first of them,
+// so a single read() returns every counter at the same instant.
+int perf_group_fd = -1;
+int perf_fds[PERF_NUM_EVENTS];
+int perf_slot[PERF_NUM_EVENTS];   // Position of each event in a group read, or -1
+int perf_group_size = 0;
+_Thread_local int perf_owner = 0; // Set on the thread that opened the group
+
+PerfSite *perf_site_list = NULL;
+
+long perf_event_open(struct perf_event_attr *attr, int group_fd) {
+    return syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+// Opens the counters for the calling thread, user space only. Returns the
+// number of events available; events the CPU or kernel does not support
+// (e.g. hardware events inside most VMs) are reported as unavailable.
+int perf_counters_init(void) {
+    if (perf_group_fd >= 0)
+        return perf_group_size;
+
+    for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perf_events[e].type;
+        attr.config = perf_events[e].config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.disabled = (perf_group_fd < 0);  // The leader starts the group
+
+        perf_fds[e] = perf_event_open(&attr, perf_group_fd);
+        perf_slot[e] = -1;
+        if (perf_fds[e] < 0)
+            continue;
+        if (perf_group_fd < 0)
+            perf_group_fd = perf_fds[e];
+        perf_slot[e] = perf_group_size++;
+    }
+
+    if (perf_group_fd >= 0) {
+        ioctl(perf_group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(perf_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        perf_owner = 1;
+    }
+    return perf_group_size;
+}
+
+void perf_counters_close(void) {
+    for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+        if (perf_slot[e] >= 0)
+            close(perf_fds[e]);
+        perf_slot[e] = -1;
+    }
+    perf_group_fd = -1;
+    perf_group_size = 0;
+    perf_owner = 0;
+}
+
+int perf_event_available(PerfEvent event) {
+    return perf_group_fd >= 0 && perf_slot[event] >= 0;
+}
+
+const char *perf_event_name(PerfEvent event) {
+    return perf_events[event].name;
+}
+
+// Current value of every event, indexed by PerfEvent (0 if unavailable)
+void perf_read(long long values[]) {
+    unsigned long long buffer[1 + PERF_NUM_EVENTS];
+
+    if (read(perf_group_fd, buffer, sizeof(buffer)) < (ssize_t)sizeof(buffer[0])) {
+        memset(values, 0, PERF_NUM_EVENTS * sizeof(long long));
+        return;
+    }
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+        values[e] = (perf_slot[e] >= 0) ? (long long)buffer[1 + perf_slot[e]] : 0;
+}
+
+void perf_region_begin(PerfSite *site, long long start[]) {
+    if (!perf_owner || site->depth++ > 0)
+        return;
+    perf_read(start);
+}
+
+void perf_region_end(PerfSite *site, long long start[]) {
+    if (!perf_owner || --site->depth > 0)
+        return;
+
+    long long now[PERF_NUM_EVENTS];
+    perf_read(now);
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+        site->totals[e] += now[e] - start[e];
+    site->calls++;
+
+    if (!site->registered) {
+        PerfSite **tail = &perf_site_list;
+        while (*tail)
+            tail = &(*tail)->next;
+        *tail = site;
+        site->registered = 1;
+    }
+}
+
+PerfSite *perf_sites(void) {
+    return perf_site_list;
+}
+
+// Zero the totals of every site, e.g. between benchmark measurements
+void perf_counters_reset(void) {
+    for (PerfSite *site = perf_site_list; site; site = site->next) {
+        site->calls = 0;
+        memset(site->totals, 0, sizeof(site->totals));
+    }
+}
+
+// Table of every site that was entered: totals, and per call in brackets
+void perf_counters_report(FILE *out) {
+    fprintf(out, "\n%-28s %12s", "Call site", "calls");
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+        fprintf(out, " %24s", perf_events[e].name);
+    fprintf(out, "\n");
+
+    for (PerfSite *site = perf_site_list; site; site = site->next) {
+        if (site->calls == 0)
+            continue;
+        fprintf(out, "%-28s %12lld", site->name, site->calls);
+        for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+            char cell[64];
+            if (perf_event_available(e))
+                snprintf(cell, sizeof(cell), "%lld (%.1f)", site->totals[e],
+                         (double)site->totals[e] / site->calls);
+            else
+                snprintf(cell, sizeof(cell), "n/a");
+            fprintf(out, " %24s", cell);
+        }
+        fprintf(out, "\n");
+    }
+}
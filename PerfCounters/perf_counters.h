@@ -0,0 +1,74 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+
+// Hardware performance counters per call site, read with Linux
+// perf_event_open. Compiled in only with -DPERF_COUNTERS (and
+// ../PerfCounters/perf_counters.c on the command line); otherwise every
+// macro below expands to nothing and the kernels are unchanged.
+//
+// A kernel marks its body as a region:
+//
+//     int partition(int arr[], int low, int high) {
+//         PERF_REGION_BEGIN("partition");
+//         ...
+//         PERF_REGION_END();
+//         return i + 1;
+//     }
+//
+// Each region is one call site with its own totals. Recursive calls of a
+// region are counted once, by the outermost call. Only the thread that
+// called perf_counters_init() is measured; regions entered on other threads
+// (e.g. by the parallel sorts' workers) are ignored.
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,      // L1 data cache read misses
+    PERF_LLC_MISSES,      // Last level cache misses
+    PERF_BRANCH_MISSES,
+    PERF_TASK_CLOCK,      // Software event, in ns; works without a PMU
+    PERF_NUM_EVENTS
+} PerfEvent;
+
+typedef struct PerfSite {
+    const char *name;
+    int depth;                           // Nesting depth of recursive calls
+    long long calls;                     // Outermost calls measured
+    long long totals[PERF_NUM_EVENTS];   // Summed over those calls
+    struct PerfSite *next;               // Registered sites, in first-use order
+    int registered;
+} PerfSite;
+
+#ifdef PERF_COUNTERS
+
+int perf_counters_init(void);
+void perf_counters_close(void);
+int perf_event_available(PerfEvent event);
+const char *perf_event_name(PerfEvent event);
+void perf_region_begin(PerfSite *site, long long start[]);
+void perf_region_end(PerfSite *site, long long start[]);
+PerfSite *perf_sites(void);
+void perf_counters_reset(void);
+void perf_counters_report(FILE *out);
+
+#define PERF_REGION_BEGIN(label)                                               \
+    static PerfSite perf_site = {.name = label};                               \
+    long long perf_start[PERF_NUM_EVENTS];                                     \
+    perf_region_begin(&perf_site, perf_start)
+
+#define PERF_REGION_END() perf_region_end(&perf_site, perf_start)
+
+#else
+
+#define perf_counters_init() ((void)0)
+#define perf_counters_close() ((void)0)
+#define perf_counters_reset() ((void)0)
+#define perf_counters_report(out) ((void)0)
+#define PERF_REGION_BEGIN(label) ((void)0)
+#define PERF_REGION_END() ((void)0)
+
+#endif
+
+#endif
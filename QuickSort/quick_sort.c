@@ -1,8 +1,41 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "../PerfCounters/perf_counters.h"
+#include "../SortingNetwork/sorting_network.h"
 
-void swap(int *a, int *b) {
+#define INSERTION_SORT_THRESHOLD 16 // Partitions this small are finished by insertion sort
+#define NINTHER_THRESHOLD 128       // Partitions this large use Tukey's ninther as pivot
+#define PRINT_LIMIT 100             // Arrays longer than this are printed truncated
+#define LOMUTO_COMPARE_LIMIT 50000  // Lomuto variants go quadratic on duplicate-heavy input
+#define PARALLEL_CUTOFF 16384       // Partitions below this size are sorted sequentially
+#define MAX_THREADS 256
+#define BLOCK_SIZE 128              // Elements classified per block in block_partition
+
+// Operation counters for SortBenchmark. With -DSORT_STATS every key
+// comparison and swap made by the sequential sorts is counted in globals
+// that the harness defines; otherwise the hooks compile to nothing.
+#ifdef SORT_STATS
+extern long long sort_comparisons;
+extern long long sort_swaps;
+#define COUNT_COMPARISON() (sort_comparisons++)
+#define COUNT_SWAP() (sort_swaps++)
+#else
+#define COUNT_COMPARISON() ((void)0)
+#define COUNT_SWAP() ((void)0)
+#endif
+
+#define SCALAR_LESS(a, b) (COUNT_COMPARISON(), (a) < (b))
+#define KEY_LESS(a, b) SCALAR_LESS((a).key, (b).key)
+
+static void swap(int *a, int *b) {
+    COUNT_SWAP();
     int temp = *a;
     *a = *b;
     *b = temp;
@@ -10,21 +43,24 @@ void swap(int *a, int *b) {
 
 // Lomuto partition scheme
 int partition(int arr[], int low, int high) {
+    PERF_REGION_BEGIN("partition");
     int pivot = arr[high]; // Choose last element as pivot
     int i = low - 1; // Index of smaller element
     
     for (int j = low; j < high; j++) {
-        if (arr[j] < pivot) {
+        if (SCALAR_LESS(arr[j], pivot)) {
             i++;
             swap(&arr[i], &arr[j]);
         }
     }
     swap(&arr[i + 1], &arr[high]);
+    PERF_REGION_END();
     return i + 1;
 }
 
 // Hoare partition scheme (alternative)
 int hoare_partition(int arr[], int low, int high) {
+    PERF_REGION_BEGIN("hoare_partition");
     int pivot = arr[low];
     int i = low - 1;
     int j = high + 1;
@@ -32,21 +68,95 @@ int hoare_partition(int arr[], int low, int high) {
     while (1) {
         do {
             i++;
-        } while (arr[i] < pivot);
+        } while (SCALAR_LESS(arr[i], pivot));
         
         do {
             j--;
-        } while (arr[j] > pivot);
+        } while (SCALAR_LESS(pivot, arr[j]));
         
-        if (i >= j)
+        if (i >= j) {
+            PERF_REGION_END();
             return j;
+        }
         
         swap(&arr[i], &arr[j]);
     }
 }
 
+// Block partition scheme (BlockQuicksort, Edelkamp & Weiss).
+// Pivot is arr[high]. Comparisons only write offsets of misplaced elements
+// into small on-stack buffers (the comparison result is added to a counter
+// instead of being branched on), then misplaced pairs are swapped in a loop
+// whose trip count does not depend on individual comparisons.
+// Returns pivot index pi with arr[low..pi-1] <= pivot <= arr[pi+1..high].
+int block_partition(int arr[], int low, int high) {
+    PERF_REGION_BEGIN("block_partition");
+    int pivot = arr[high];
+    int l = low, r = high - 1; // arr[l..r] is not yet partitioned
+    unsigned char offsets_l[BLOCK_SIZE], offsets_r[BLOCK_SIZE];
+    int start_l = 0, start_r = 0;
+    int num_l = 0, num_r = 0;
+    
+    while (r - l + 1 > 2 * BLOCK_SIZE) {
+        // Left block: collect elements that do not belong on the left
+        if (num_l == 0) {
+            start_l = 0;
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                offsets_l[num_l] = i;
+                num_l += !SCALAR_LESS(arr[l + i], pivot);
+            }
+        }
+        // Right block: collect elements that do not belong on the right
+        if (num_r == 0) {
+            start_r = 0;
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                offsets_r[num_r] = i;
+                num_r += !SCALAR_LESS(pivot, arr[r - i]);
+            }
+        }
+        
+        int num = (num_l < num_r) ? num_l : num_r;
+        for (int k = 0; k < num; k++) {
+            swap(&arr[l + offsets_l[start_l + k]], &arr[r - offsets_r[start_r + k]]);
+        }
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+        
+        // A block is done once all its misplaced elements were swapped
+        if (num_l == 0)
+            l += BLOCK_SIZE;
+        if (num_r == 0)
+            r -= BLOCK_SIZE;
+    }
+    
+    // Fewer than two blocks left (including any half-processed block):
+    // finish with a plain Hoare-style scan
+    while (1) {
+        while (l <= r && SCALAR_LESS(arr[l], pivot))
+            l++;
+        while (l <= r && SCALAR_LESS(pivot, arr[r]))
+            r--;
+        if (l >= r)
+            break;
+        swap(&arr[l], &arr[r]);
+        l++;
+        r--;
+    }
+    
+    swap(&arr[l], &arr[high]);
+    PERF_REGION_END();
+    return l;
+}
+
+// Partitions of up to SORT_NETWORK_MAX keys are finished by a SIMD sorting
+// network instead of recursing down to single elements
 void quick_sort(int arr[], int low, int high) {
     if (low < high) {
+        if (int_network_sort(arr + low, high - low + 1))
+            return;
+        
         int pi = partition(arr, low, high);
         
         // Recursively sort elements before and after partition
@@ -57,6 +167,9 @@ void quick_sort(int arr[], int low, int high) {
 
 void quick_sort_hoare(int arr[], int low, int high) {
     if (low < high) {
+        if (int_network_sort(arr + low, high - low + 1))
+            return;
+        
         int pi = hoare_partition(arr, low, high);
         
         quick_sort_hoare(arr, low, pi);
@@ -73,6 +186,9 @@ int randomized_partition(int arr[], int low, int high) {
 
 void randomized_quick_sort(int arr[], int low, int high) {
     if (low < high) {
+        if (int_network_sort(arr + low, high - low + 1))
+            return;
+        
         int pi = randomized_partition(arr, low, high);
         
         randomized_quick_sort(arr, low, pi - 1);
@@ -80,23 +196,913 @@ void randomized_quick_sort(int arr[], int low, int high) {
     }
 }
 
-void print_array(int arr[], int size) {
-    for (int i = 0; i < size; i++) {
+// Depth budget 2*floor(log2(n)) after which introsort switches to heap sort
+int introsort_depth_limit(int n) {
+    int depth_limit = 0;
+    for (int m = n; m > 1; m >>= 1)
+        depth_limit++;
+    return 2 * depth_limit;
+}
+
+// Introsort: quick sort with median-of-three/ninther pivots that falls back
+// to heap sort after 2*log2(n) levels, guaranteeing O(n log n) worst case.
+//
+// DEFINE_INTROSORT(name, type, less, network) expands to an introsort
+// specialized for `type`, with the comparison macro less(a, b) inlined at
+// every call site:
+//   void name(type arr[], int low, int high);
+// plus the helpers it is built from:
+//   name##_insertion_sort  insertion sort used to finish small partitions
+//   name##_choose_pivot    moves a median-of-three (ninther) pivot to arr[high]
+//   name##_partition       Lomuto partition around arr[high]
+//   name##_heap_sort_range heap sort fallback once the depth budget runs out
+//   name##_loop            the introsort driver, parameterized by the kernel
+// Partitions small enough for network##_sort(arr, n) (int_network_sort, see
+// SortingNetwork/) are handed to it; no_network never takes one.
+#define DEFINE_INTROSORT(name, type, less, network)                            \
+void name##_swap(type *a, type *b) {                                           \
+    COUNT_SWAP();                                                              \
+    type temp = *a;                                                            \
+    *a = *b;                                                                   \
+    *b = temp;                                                                 \
+}                                                                              \
+                                                                               \
+void name##_insertion_sort(type arr[], int low, int high) {                    \
+    for (int i = low + 1; i <= high; i++) {                                    \
+        type key = arr[i];                                                     \
+        int j = i - 1;                                                         \
+                                                                               \
+        while (j >= low && less(key, arr[j])) {                                \
+            arr[j + 1] = arr[j];                                               \
+            j--;                                                               \
+        }                                                                      \
+        arr[j + 1] = key;                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+int name##_median_of_three(type arr[], int a, int b, int c) {                  \
+    if (less(arr[a], arr[b])) {                                                \
+        if (less(arr[b], arr[c]))                                              \
+            return b;                                                          \
+        return less(arr[a], arr[c]) ? c : a;                                   \
+    }                                                                          \
+    if (less(arr[a], arr[c]))                                                  \
+        return a;                                                              \
+    return less(arr[b], arr[c]) ? c : b;                                       \
+}                                                                              \
+                                                                               \
+void name##_choose_pivot(type arr[], int low, int high) {                      \
+    int n = high - low + 1;                                                    \
+    int mid = low + n / 2;                                                     \
+    int median;                                                                \
+                                                                               \
+    if (n > NINTHER_THRESHOLD) {                                               \
+        /* Tukey's ninther: median of three medians of three */               \
+        int step = n / 8;                                                      \
+        int m1 = name##_median_of_three(arr, low, low + step, low + 2 * step); \
+        int m2 = name##_median_of_three(arr, mid - step, mid, mid + step);     \
+        int m3 = name##_median_of_three(arr, high - 2 * step, high - step, high); \
+        median = name##_median_of_three(arr, m1, m2, m3);                      \
+    } else {                                                                   \
+        median = name##_median_of_three(arr, low, mid, high);                  \
+    }                                                                          \
+    name##_swap(&arr[median], &arr[high]);                                     \
+}                                                                              \
+                                                                               \
+int name##_partition(type arr[], int low, int high) {                          \
+    PERF_REGION_BEGIN(#name "_partition");                                     \
+    type pivot = arr[high];                                                    \
+    int i = low - 1;                                                           \
+                                                                               \
+    for (int j = low; j < high; j++) {                                         \
+        if (less(arr[j], pivot)) {                                             \
+            i++;                                                               \
+            name##_swap(&arr[i], &arr[j]);                                     \
+        }                                                                      \
+    }                                                                          \
+    name##_swap(&arr[i + 1], &arr[high]);                                      \
+    PERF_REGION_END();                                                         \
+    return i + 1;                                                              \
+}                                                                              \
+                                                                               \
+void name##_sift_down(type arr[], int n, int i) {                              \
+    type root = arr[i];                                                        \
+    int child;                                                                 \
+                                                                               \
+    while ((child = 2 * i + 1) < n) {                                          \
+        if (child + 1 < n && less(arr[child], arr[child + 1]))                 \
+            child++;                                                           \
+        if (!less(root, arr[child]))                                           \
+            break;                                                             \
+        arr[i] = arr[child];                                                   \
+        i = child;                                                             \
+    }                                                                          \
+    arr[i] = root;                                                             \
+}                                                                              \
+                                                                               \
+void name##_heap_sort_range(type arr[], int low, int high) {                   \
+    type *base = arr + low;                                                    \
+    int n = high - low + 1;                                                    \
+                                                                               \
+    for (int i = n / 2 - 1; i >= 0; i--)                                       \
+        name##_sift_down(base, n, i);                                          \
+                                                                               \
+    for (int i = n - 1; i > 0; i--) {                                          \
+        name##_swap(&base[0], &base[i]);                                       \
+        name##_sift_down(base, i, 0);                                          \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name##_loop(type arr[], int low, int high, int depth_limit,               \
+                 int (*partition_fn)(type arr[], int low, int high)) {         \
+    while (high - low + 1 > INSERTION_SORT_THRESHOLD) {                        \
+        if (network##_sort(arr + low, high - low + 1))                         \
+            return;                                                            \
+                                                                               \
+        /* Too many bad pivots: switch to heap sort */                        \
+        if (depth_limit == 0) {                                                \
+            name##_heap_sort_range(arr, low, high);                            \
+            return;                                                            \
+        }                                                                      \
+        depth_limit--;                                                         \
+                                                                               \
+        name##_choose_pivot(arr, low, high);                                   \
+        int pi = partition_fn(arr, low, high);                                 \
+                                                                               \
+        /* Recurse into the smaller side, loop on the larger one */           \
+        if (pi - low < high - pi) {                                            \
+            name##_loop(arr, low, pi - 1, depth_limit, partition_fn);          \
+            low = pi + 1;                                                      \
+        } else {                                                               \
+            name##_loop(arr, pi + 1, high, depth_limit, partition_fn);         \
+            high = pi - 1;                                                     \
+        }                                                                      \
+    }                                                                          \
+    if (!network##_sort(arr + low, high - low + 1))                            \
+        name##_insertion_sort(arr, low, high);                                 \
+}                                                                              \
+                                                                               \
+void name(type arr[], int low, int high) {                                     \
+    int n = high - low + 1;                                                    \
+                                                                               \
+    if (n < 2)                                                                 \
+        return;                                                                \
+                                                                               \
+    name##_loop(arr, low, high, introsort_depth_limit(n), name##_partition);   \
+}
+
+// 16-byte record: sort key plus an opaque payload (e.g. a row id)
+typedef struct {
+    long long key;
+    long long payload;
+} KeyPayload;
+
+// Specializations for common key types. Floats must not contain NaN.
+DEFINE_INTROSORT(introsort, int, SCALAR_LESS, int_network)
+DEFINE_INTROSORT(introsort_i64, long long, SCALAR_LESS, no_network)
+DEFINE_INTROSORT(introsort_float, float, SCALAR_LESS, no_network)
+DEFINE_INTROSORT(introsort_pair, KeyPayload, KEY_LESS, no_network)
+
+// Comparator in the qsort convention: negative, zero or positive
+typedef int (*compare_function)(const void *a, const void *b);
+
+// Element array of runtime size, for types without a specialization
+typedef struct {
+    char *base;
+    size_t size;
+    compare_function cmp;
+} GenericArray;
+
+#define GENERIC_AT(g, i) ((g)->base + (size_t)(i) * (g)->size)
+
+static void swap_bytes(void *a, void *b, size_t size) {
+    unsigned char *p = a, *q = b;
+    while (size--) {
+        unsigned char temp = *p;
+        *p++ = *q;
+        *q++ = temp;
+    }
+}
+
+void generic_insertion_sort(GenericArray *g, int low, int high) {
+    for (int i = low + 1; i <= high; i++) {
+        for (int j = i; j > low && g->cmp(GENERIC_AT(g, j - 1), GENERIC_AT(g, j)) > 0; j--)
+            swap_bytes(GENERIC_AT(g, j - 1), GENERIC_AT(g, j), g->size);
+    }
+}
+
+int generic_median_of_three(GenericArray *g, int a, int b, int c) {
+    if (g->cmp(GENERIC_AT(g, a), GENERIC_AT(g, b)) < 0) {
+        if (g->cmp(GENERIC_AT(g, b), GENERIC_AT(g, c)) < 0)
+            return b;
+        return (g->cmp(GENERIC_AT(g, a), GENERIC_AT(g, c)) < 0) ? c : a;
+    }
+    if (g->cmp(GENERIC_AT(g, a), GENERIC_AT(g, c)) < 0)
+        return a;
+    return (g->cmp(GENERIC_AT(g, b), GENERIC_AT(g, c)) < 0) ? c : b;
+}
+
+// Move a median-of-three (ninther) pivot to arr[high], then Lomuto partition
+int generic_partition(GenericArray *g, int low, int high) {
+    int n = high - low + 1;
+    int mid = low + n / 2;
+    int median;
+    
+    if (n > NINTHER_THRESHOLD) {
+        int step = n / 8;
+        int m1 = generic_median_of_three(g, low, low + step, low + 2 * step);
+        int m2 = generic_median_of_three(g, mid - step, mid, mid + step);
+        int m3 = generic_median_of_three(g, high - 2 * step, high - step, high);
+        median = generic_median_of_three(g, m1, m2, m3);
+    } else {
+        median = generic_median_of_three(g, low, mid, high);
+    }
+    if (median != high)
+        swap_bytes(GENERIC_AT(g, median), GENERIC_AT(g, high), g->size);
+    
+    char *pivot = GENERIC_AT(g, high);
+    int i = low - 1;
+    for (int j = low; j < high; j++) {
+        if (g->cmp(GENERIC_AT(g, j), pivot) < 0) {
+            i++;
+            if (i != j)
+                swap_bytes(GENERIC_AT(g, i), GENERIC_AT(g, j), g->size);
+        }
+    }
+    if (i + 1 != high)
+        swap_bytes(GENERIC_AT(g, i + 1), pivot, g->size);
+    return i + 1;
+}
+
+void generic_sift_down(GenericArray *g, int low, int n, int i) {
+    int child;
+    while ((child = 2 * i + 1) < n) {
+        if (child + 1 < n &&
+            g->cmp(GENERIC_AT(g, low + child), GENERIC_AT(g, low + child + 1)) < 0)
+            child++;
+        if (g->cmp(GENERIC_AT(g, low + i), GENERIC_AT(g, low + child)) >= 0)
+            break;
+        swap_bytes(GENERIC_AT(g, low + i), GENERIC_AT(g, low + child), g->size);
+        i = child;
+    }
+}
+
+void generic_heap_sort_range(GenericArray *g, int low, int high) {
+    int n = high - low + 1;
+    
+    for (int i = n / 2 - 1; i >= 0; i--)
+        generic_sift_down(g, low, n, i);
+    
+    for (int i = n - 1; i > 0; i--) {
+        swap_bytes(GENERIC_AT(g, low), GENERIC_AT(g, low + i), g->size);
+        generic_sift_down(g, low, i, 0);
+    }
+}
+
+void generic_introsort_loop(GenericArray *g, int low, int high, int depth_limit) {
+    while (high - low + 1 > INSERTION_SORT_THRESHOLD) {
+        if (depth_limit == 0) {
+            generic_heap_sort_range(g, low, high);
+            return;
+        }
+        depth_limit--;
+        
+        int pi = generic_partition(g, low, high);
+        
+        if (pi - low < high - pi) {
+            generic_introsort_loop(g, low, pi - 1, depth_limit);
+            low = pi + 1;
+        } else {
+            generic_introsort_loop(g, pi + 1, high, depth_limit);
+            high = pi - 1;
+        }
+    }
+    generic_insertion_sort(g, low, high);
+}
+
+// Introsort with a qsort-compatible interface: count elements of `size`
+// bytes each, ordered by cmp. Prefer a DEFINE_INTROSORT specialization on
+// hot paths, which inlines the comparison instead of calling through cmp.
+void introsort_generic(void *base, size_t count, size_t size, compare_function cmp) {
+    GenericArray g = {base, size, cmp};
+    
+    if (count < 2)
+        return;
+    
+    generic_introsort_loop(&g, 0, (int)count - 1, introsort_depth_limit((int)count));
+}
+
+// Introsort driven by the branchless block_partition kernel
+void block_quick_sort(int arr[], int low, int high) {
+    int n = high - low + 1;
+    
+    if (n < 2)
+        return;
+    
+    introsort_loop(arr, low, high, introsort_depth_limit(n), block_partition);
+}
+
+// Bentley-McIlroy three-way partition around pivot arr[low].
+// Keys equal to the pivot are swapped to both ends while scanning and moved
+// to the middle at the end, leaving
+//   arr[low..*lt-1] < pivot, arr[*lt..*gt] == pivot, arr[*gt+1..high] > pivot
+void three_way_partition(int arr[], int low, int high, int *lt, int *gt) {
+    PERF_REGION_BEGIN("three_way_partition");
+    int pivot = arr[low];
+    int i = low, j = high + 1;
+    int p = low, q = high + 1;
+    
+    while (1) {
+        while (SCALAR_LESS(arr[++i], pivot))
+            if (i == high) break;
+        while (SCALAR_LESS(pivot, arr[--j]))
+            if (j == low) break;
+        
+        if (i == j && arr[i] == pivot)
+            swap(&arr[++p], &arr[i]);
+        if (i >= j)
+            break;
+        
+        swap(&arr[i], &arr[j]);
+        if (arr[i] == pivot)
+            swap(&arr[++p], &arr[i]);
+        if (arr[j] == pivot)
+            swap(&arr[--q], &arr[j]);
+    }
+    
+    // Bring the equal keys parked at both ends into the middle
+    i = j + 1;
+    for (int k = low; k <= p; k++)
+        swap(&arr[k], &arr[j--]);
+    for (int k = high; k >= q; k--)
+        swap(&arr[k], &arr[i++]);
+    
+    *lt = j + 1;
+    *gt = i - 1;
+    PERF_REGION_END();
+}
+
+// Quick Sort with three-way partitioning: runs of keys equal to the pivot
+// are excluded from recursion, so low-cardinality input sorts in O(n log k)
+void quick_sort_3way(int arr[], int low, int high) {
+    while (high - low + 1 > INSERTION_SORT_THRESHOLD) {
+        int lt, gt;
+        
+        introsort_choose_pivot(arr, low, high);
+        swap(&arr[low], &arr[high]);
+        three_way_partition(arr, low, high, &lt, &gt);
+        
+        // Recurse into the smaller side, loop on the larger one
+        if (lt - low < high - gt) {
+            quick_sort_3way(arr, low, lt - 1);
+            low = gt + 1;
+        } else {
+            quick_sort_3way(arr, gt + 1, high);
+            high = lt - 1;
+        }
+    }
+    if (!int_network_sort(arr + low, high - low + 1))
+        introsort_insertion_sort(arr, low, high);
+}
+
+int median_of_medians(int arr[], int low, int high);
+
+// Partially order arr[low..high] so that arr[k] holds the key it would hold
+// if the range were sorted, with no larger key before it and no smaller key
+// after it. Each step partitions three ways around a pivot and keeps only
+// the side containing k, so equal keys never cost extra passes.
+//
+// Introselect: pivots are chosen like introsort's (median of three or
+// ninther), expected O(n). If the range has not at least halved after two
+// partitions, the rest of the selection switches to the median-of-medians
+// pivot, which guarantees O(n) in the worst case. deterministic = 1 uses
+// median of medians from the start.
+void select_kth(int arr[], int low, int high, int k, int deterministic) {
+    int checkpoint_size = high - low + 1;
+    int partitions = 0;
+    
+    while (high - low + 1 > INSERTION_SORT_THRESHOLD) {
+        int lt, gt;
+        
+        if (deterministic) {
+            swap(&arr[low], &arr[median_of_medians(arr, low, high)]);
+        } else {
+            introsort_choose_pivot(arr, low, high);
+            swap(&arr[low], &arr[high]);
+        }
+        three_way_partition(arr, low, high, &lt, &gt);
+        
+        if (k < lt)
+            high = lt - 1;
+        else if (k > gt)
+            low = gt + 1;
+        else
+            return;
+        
+        if (!deterministic && ++partitions % 2 == 0) {
+            if (high - low + 1 > checkpoint_size / 2)
+                deterministic = 1;  // Pivots keep failing: stop trusting them
+            checkpoint_size = high - low + 1;
+        }
+    }
+    introsort_insertion_sort(arr, low, high);
+}
+
+// Index of a pivot for arr[low..high] with at least ~30% of the keys on
+// either side (BFPRT): the median of each group of five is moved to the
+// front, and the median of those medians is selected deterministically
+int median_of_medians(int arr[], int low, int high) {
+    int medians = low;
+    
+    for (int i = low; i <= high; i += 5) {
+        int group_high = (i + 4 < high) ? i + 4 : high;
+        introsort_insertion_sort(arr, i, group_high);
+        swap(&arr[medians++], &arr[i + (group_high - i) / 2]);
+    }
+    
+    int mid = low + (medians - low - 1) / 2;
+    select_kth(arr, low, medians - 1, mid, 1);
+    return mid;
+}
+
+// Returns the k-th smallest key (0-based) of arr[low..high], partially
+// ordering the range as select_kth does
+int introselect(int arr[], int low, int high, int k) {
+    select_kth(arr, low, high, k, 0);
+    return arr[k];
+}
+
+// Reorder arr[0..n-1] so arr[k] is the key a full sort would put there,
+// with smaller-or-equal keys before it and greater-or-equal keys after it
+void nth_element(int arr[], int n, int k) {
+    if (k < 0 || k >= n)
+        return;
+    select_kth(arr, 0, n - 1, k, 0);
+}
+
+// Range of the array still to be sorted by one worker
+typedef struct {
+    int low;
+    int high;
+} SortTask;
+
+// Per-worker double-ended task queue: the owner pushes and pops at the
+// bottom (LIFO, cache-warm), idle workers steal from the top (oldest,
+// largest ranges)
+typedef struct {
+    SortTask *tasks;
+    int top;
+    int bottom;
+    int capacity;
+    pthread_mutex_t lock;
+} TaskDeque;
+
+typedef struct {
+    int *arr;
+    TaskDeque *deques;
+    int num_threads;
+    atomic_int pending; // Tasks pushed but not yet finished
+} ThreadPool;
+
+typedef struct {
+    ThreadPool *pool;
+    int id;
+    unsigned int seed;
+} WorkerArg;
+
+void deque_init(TaskDeque *dq) {
+    dq->capacity = 64;
+    dq->tasks = malloc(dq->capacity * sizeof(SortTask));
+    if (!dq->tasks) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    dq->top = 0;
+    dq->bottom = 0;
+    pthread_mutex_init(&dq->lock, NULL);
+}
+
+void deque_destroy(TaskDeque *dq) {
+    pthread_mutex_destroy(&dq->lock);
+    free(dq->tasks);
+}
+
+void deque_push(TaskDeque *dq, SortTask task) {
+    pthread_mutex_lock(&dq->lock);
+    if (dq->bottom == dq->capacity) {
+        if (dq->top > 0) {
+            // Reclaim the slots freed by steals before growing
+            memmove(dq->tasks, dq->tasks + dq->top,
+                    (dq->bottom - dq->top) * sizeof(SortTask));
+            dq->bottom -= dq->top;
+            dq->top = 0;
+        } else {
+            SortTask *grown = realloc(dq->tasks, 2 * dq->capacity * sizeof(SortTask));
+            if (!grown) {
+                printf("Memory allocation failed!\n");
+                exit(1);
+            }
+            dq->tasks = grown;
+            dq->capacity *= 2;
+        }
+    }
+    dq->tasks[dq->bottom++] = task;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+int deque_pop(TaskDeque *dq, SortTask *task) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->bottom > dq->top) {
+        *task = dq->tasks[--dq->bottom];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+int deque_steal(TaskDeque *dq, SortTask *task) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->bottom > dq->top) {
+        *task = dq->tasks[dq->top++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+// Try every other worker once, starting from a random victim
+int try_steal(ThreadPool *pool, int id, unsigned int *seed, SortTask *task) {
+    int start = rand_r(seed) % pool->num_threads;
+    for (int k = 0; k < pool->num_threads; k++) {
+        int victim = (start + k) % pool->num_threads;
+        if (victim != id && deque_steal(&pool->deques[victim], task))
+            return 1;
+    }
+    return 0;
+}
+
+// Partition large ranges, handing one side to the pool each time, and sort
+// the remaining small range sequentially with introsort (Lomuto partition).
+// Large ranges use a median-of-three pivot and three_way_partition rather
+// than the Lomuto partition: this loop has no depth limit, and Lomuto splits
+// a run of equal keys into n - 1 and 0, which would make duplicate-heavy
+// input quadratic before the introsort cutoff is ever reached
+void run_sort_task(ThreadPool *pool, int id, SortTask task) {
+    int *arr = pool->arr;
+    int low = task.low, high = task.high;
+    
+    while (high - low + 1 > PARALLEL_CUTOFF) {
+        int lt, gt;
+        
+        introsort_choose_pivot(arr, low, high);
+        swap(&arr[low], &arr[high]);
+        three_way_partition(arr, low, high, &lt, &gt);
+        
+        // Publish the larger side for thieves, keep working on the smaller
+        SortTask spawned;
+        if (lt - low > high - gt) {
+            spawned.low = low;
+            spawned.high = lt - 1;
+            low = gt + 1;
+        } else {
+            spawned.low = gt + 1;
+            spawned.high = high;
+            high = lt - 1;
+        }
+        atomic_fetch_add(&pool->pending, 1);
+        deque_push(&pool->deques[id], spawned);
+    }
+    introsort(arr, low, high);
+}
+
+void *parallel_worker(void *arg) {
+    WorkerArg *worker = arg;
+    ThreadPool *pool = worker->pool;
+    SortTask task;
+    
+    while (1) {
+        if (deque_pop(&pool->deques[worker->id], &task) ||
+            try_steal(pool, worker->id, &worker->seed, &task)) {
+            run_sort_task(pool, worker->id, task);
+            atomic_fetch_sub(&pool->pending, 1);
+        } else if (atomic_load(&pool->pending) == 0) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Parallel Quick Sort on a work-stealing pool of num_threads workers
+void parallel_quick_sort(int arr[], int low, int high, int num_threads) {
+    if (num_threads < 1)
+        num_threads = 1;
+    if (num_threads > MAX_THREADS)
+        num_threads = MAX_THREADS;
+    
+    if (high - low + 1 <= PARALLEL_CUTOFF) {
+        introsort(arr, low, high);
+        return;
+    }
+    
+    ThreadPool pool;
+    pthread_t threads[MAX_THREADS];
+    WorkerArg args[MAX_THREADS];
+    
+    pool.arr = arr;
+    pool.num_threads = num_threads;
+    pool.deques = malloc(num_threads * sizeof(TaskDeque));
+    if (!pool.deques) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int t = 0; t < num_threads; t++)
+        deque_init(&pool.deques[t]);
+    
+    SortTask root = {low, high};
+    atomic_init(&pool.pending, 1);
+    deque_push(&pool.deques[0], root);
+    
+    for (int t = 0; t < num_threads; t++) {
+        args[t].pool = &pool;
+        args[t].id = t;
+        args[t].seed = 12345u + 7919u * t;
+        pthread_create(&threads[t], NULL, parallel_worker, &args[t]);
+    }
+    for (int t = 0; t < num_threads; t++)
+        pthread_join(threads[t], NULL);
+    
+    for (int t = 0; t < num_threads; t++)
+        deque_destroy(&pool.deques[t]);
+    free(pool.deques);
+}
+
+// SortBenchmark builds this file with -DSORT_NO_MAIN and calls the sorts
+// itself; the menu, its helpers and the benchmarks below are left out
+#ifndef SORT_NO_MAIN
+
+static int default_thread_count(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+}
+
+static void print_array(int arr[], int size) {
+    int shown = (size > PRINT_LIMIT) ? PRINT_LIMIT : size;
+    for (int i = 0; i < shown; i++) {
         printf("%d ", arr[i]);
     }
+    if (shown < size) {
+        printf("... (%d more)", size - shown);
+    }
     printf("\n");
 }
 
-void copy_array(int source[], int dest[], int size) {
+static void copy_array(int source[], int dest[], int size) {
     for (int i = 0; i < size; i++) {
         dest[i] = source[i];
     }
 }
 
+// Generate random array of keys in [0, max_val)
+static void generate_random_array(int arr[], int size, int max_val) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = rand() % max_val;
+    }
+}
+
+// Generate keys in [0, num_keys) where key k has probability proportional
+// to 1 / (k + 1)^exponent, i.e. a Zipf distribution with many duplicates
+void generate_zipf_array(int arr[], int size, int num_keys, double exponent) {
+    double *cdf = malloc(num_keys * sizeof(double));
+    if (!cdf) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    
+    double total = 0.0;
+    for (int k = 0; k < num_keys; k++) {
+        total += 1.0 / pow(k + 1, exponent);
+        cdf[k] = total;
+    }
+    
+    for (int i = 0; i < size; i++) {
+        double u = ((double)rand() / ((double)RAND_MAX + 1.0)) * total;
+        
+        // Binary search for the first rank whose cumulative weight exceeds u
+        int lo = 0, hi = num_keys - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (cdf[mid] <= u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        arr[i] = lo;
+    }
+    
+    free(cdf);
+}
+
+// Generate random keys over the full non-negative 32-bit int range
+static void generate_full_range_array(int arr[], int size) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = (int)((((unsigned int)rand() << 16) ^ (unsigned int)rand()) & 0x7fffffff);
+    }
+}
+
+static int is_sorted(int arr[], int size) {
+    for (int i = 1; i < size; i++) {
+        if (arr[i - 1] > arr[i])
+            return 0;
+    }
+    return 1;
+}
+
+typedef void (*sort_function)(int arr[], int low, int high);
+
+// Time every variant on a copy of the same input. Unless the keys are
+// known to be distinct-heavy, Lomuto variants are skipped on large input
+void compare_variants(int arr[], int temp[], int size, int skip_lomuto) {
+    const char *names[] = {
+        "Standard Quick Sort (Lomuto)",
+        "Quick Sort (Hoare)",
+        "Randomized Quick Sort",
+        "Introsort",
+        "Three-way Quick Sort",
+        "Block Quick Sort"
+    };
+    sort_function sorts[] = {
+        quick_sort,
+        quick_sort_hoare,
+        randomized_quick_sort,
+        introsort,
+        quick_sort_3way,
+        block_quick_sort
+    };
+    int uses_lomuto[] = {1, 0, 1, 0, 0, 0};
+    int count = sizeof(sorts) / sizeof(sorts[0]);
+    
+    printf("\nComparison Results:\n");
+    for (int v = 0; v < count; v++) {
+        if (uses_lomuto[v] && skip_lomuto && size > LOMUTO_COMPARE_LIMIT) {
+            printf("%-30s skipped (size > %d)\n", names[v], LOMUTO_COMPARE_LIMIT);
+            continue;
+        }
+        
+        copy_array(arr, temp, size);
+        clock_t start = clock();
+        sorts[v](temp, 0, size - 1);
+        clock_t end = clock();
+        
+        printf("%-30s %f seconds%s\n", names[v],
+               ((double)(end - start)) / CLOCKS_PER_SEC,
+               is_sorted(temp, size) ? "" : "  (NOT SORTED)");
+    }
+}
+
+static int compare_key_payload(const void *a, const void *b) {
+    long long ka = ((const KeyPayload *)a)->key;
+    long long kb = ((const KeyPayload *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+int records_sorted(KeyPayload records[], int size) {
+    for (int i = 1; i < size; i++) {
+        if (records[i - 1].key > records[i].key)
+            return 0;
+    }
+    return 1;
+}
+
+// Sort 16-byte records keyed by the input values three ways: libc qsort,
+// the comparator-based introsort_generic and the inlined introsort_pair
+static void generic_records_benchmark(int arr[], int size) {
+    KeyPayload *source = malloc(size * sizeof(KeyPayload));
+    KeyPayload *records = malloc(size * sizeof(KeyPayload));
+    if (!source || !records) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    for (int i = 0; i < size; i++) {
+        source[i].key = arr[i];
+        source[i].payload = i;
+    }
+    
+    printf("\nSorting %d key/payload records (%zu bytes each):\n",
+           size, sizeof(KeyPayload));
+    for (int method = 0; method < 3; method++) {
+        memcpy(records, source, size * sizeof(KeyPayload));
+        clock_t start = clock();
+        if (method == 0)
+            qsort(records, size, sizeof(KeyPayload), compare_key_payload);
+        else if (method == 1)
+            introsort_generic(records, size, sizeof(KeyPayload), compare_key_payload);
+        else
+            introsort_pair(records, 0, size - 1);
+        clock_t end = clock();
+        
+        const char *names[] = {"libc qsort", "introsort_generic", "introsort_pair"};
+        printf("%-30s %f seconds%s\n", names[method],
+               ((double)(end - start)) / CLOCKS_PER_SEC,
+               records_sorted(records, size) ? "" : "  (NOT SORTED)");
+    }
+    
+    free(source);
+    free(records);
+}
+
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Time parallel_quick_sort with 1, 2, 4, ... threads up to max_threads.
+// Wall-clock time is used since clock() adds up CPU time of all threads
+void parallel_scaling_benchmark(int arr[], int temp[], int size, int max_threads) {
+    double base_time = 0.0;
+    
+    printf("\nParallel scaling (%d elements):\n", size);
+    printf("%8s %12s %9s\n", "Threads", "Seconds", "Speedup");
+    
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads)
+            threads = max_threads;
+        
+        copy_array(arr, temp, size);
+        double start = wall_time();
+        parallel_quick_sort(temp, 0, size - 1, threads);
+        double elapsed = wall_time() - start;
+        
+        if (threads == 1)
+            base_time = elapsed;
+        printf("%8d %12f %8.2fx%s\n", threads, elapsed,
+               elapsed > 0.0 ? base_time / elapsed : 0.0,
+               is_sorted(temp, size) ? "" : "  (NOT SORTED)");
+        
+        if (threads == max_threads)
+            break;
+    }
+}
+
+// Check that arr[k] == expected and that arr[0..n-1] is partitioned around it
+int is_selected(int arr[], int size, int k, int expected) {
+    if (arr[k] != expected)
+        return 0;
+    for (int i = 0; i < size; i++) {
+        if ((i < k && arr[i] > arr[k]) || (i > k && arr[i] < arr[k]))
+            return 0;
+    }
+    return 1;
+}
+
+// Time nth_element (introselect) and pure median-of-medians selection for
+// several ranks against sorting everything with introsort
+void selection_benchmark(int arr[], int temp[], int size) {
+    int ranks[] = { 0, size / 100, size / 2, size - 1 };
+    int *sorted = malloc(size * sizeof(int));
+    
+    if (!sorted) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+    copy_array(arr, sorted, size);
+    clock_t start = clock();
+    introsort(sorted, 0, size - 1);
+    double sort_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+    
+    printf("\nSelection in %d keys; full introsort: %f seconds\n", size, sort_time);
+    printf("%10s %16s %9s %20s  %s\n", "k", "nth_element (s)", "Speedup",
+           "Median of medians (s)", "Result");
+    for (int r = 0; r < 4; r++) {
+        int k = ranks[r];
+        
+        copy_array(arr, temp, size);
+        start = clock();
+        nth_element(temp, size, k);
+        double select_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        int ok = is_selected(temp, size, k, sorted[k]);
+        
+        copy_array(arr, temp, size);
+        start = clock();
+        select_kth(temp, 0, size - 1, k, 1);
+        double mom_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+        ok &= is_selected(temp, size, k, sorted[k]);
+        
+        printf("%10d %16f %8.1fx %20f  %s\n", k, select_time,
+               select_time > 0.0 ? sort_time / select_time : 0.0, mom_time,
+               ok ? "ok" : "WRONG");
+    }
+    free(sorted);
+}
+
 int main() {
     srand(time(NULL)); // Seed for random number generation
     
-    int size, choice;
+    int size, choice, input_choice;
     
     printf("Enter array size: ");
     scanf("%d", &size);
@@ -109,9 +1115,29 @@ int main() {
         return 1;
     }
     
-    printf("Enter %d elements:\n", size);
-    for (int i = 0; i < size; i++) {
-        scanf("%d", &arr[i]);
+    printf("\nChoose input method:\n");
+    printf("1. Manual input\n");
+    printf("2. Random generation\n");
+    printf("3. Zipf-distributed keys (duplicate-heavy)\n");
+    printf("4. Random full-range 32-bit keys\n");
+    printf("Enter choice (1-4): ");
+    scanf("%d", &input_choice);
+    
+    if (input_choice == 2) {
+        generate_random_array(arr, size, 1000);
+    } else if (input_choice == 3) {
+        int num_keys;
+        double exponent;
+        printf("Enter number of distinct keys and Zipf exponent (e.g. 100 1.0): ");
+        scanf("%d %lf", &num_keys, &exponent);
+        generate_zipf_array(arr, size, num_keys, exponent);
+    } else if (input_choice == 4) {
+        generate_full_range_array(arr, size);
+    } else {
+        printf("Enter %d elements:\n", size);
+        for (int i = 0; i < size; i++) {
+            scanf("%d", &arr[i]);
+        }
     }
     
     printf("\nOriginal array: ");
@@ -121,12 +1147,60 @@ int main() {
     printf("1. Standard Quick Sort (Lomuto partition)\n");
     printf("2. Quick Sort with Hoare partition\n");
     printf("3. Randomized Quick Sort\n");
-    printf("Enter choice (1-3): ");
+    printf("4. Introsort (median-of-three, heap sort fallback)\n");
+    printf("5. Three-way Quick Sort (Bentley-McIlroy partition)\n");
+    printf("6. Block Quick Sort (branchless block partition)\n");
+    printf("7. Compare all variants\n");
+    printf("8. Parallel Quick Sort (work-stealing thread pool)\n");
+    printf("9. Parallel scaling benchmark\n");
+    printf("10. Generic API on 16-byte key/payload records\n");
+    printf("11. Selection (nth_element) vs full sort\n");
+    printf("Enter choice (1-11): ");
     scanf("%d", &choice);
     
+    if (choice == 7) {
+        compare_variants(arr, temp, size, input_choice != 4);
+        printf("Sorted array: ");
+        print_array(temp, size);
+        free(arr);
+        free(temp);
+        return 0;
+    }
+    
+    if (choice == 10) {
+        generic_records_benchmark(arr, size);
+        free(arr);
+        free(temp);
+        return 0;
+    }
+    
+    if (choice == 11) {
+        selection_benchmark(arr, temp, size);
+        free(arr);
+        free(temp);
+        return 0;
+    }
+    
+    int num_threads = default_thread_count();
+    if (choice == 8 || choice == 9) {
+        printf("Enter number of threads (0 = %d online cores): ", num_threads);
+        int requested;
+        scanf("%d", &requested);
+        if (requested > 0)
+            num_threads = requested;
+    }
+    
+    if (choice == 9) {
+        parallel_scaling_benchmark(arr, temp, size, num_threads);
+        free(arr);
+        free(temp);
+        return 0;
+    }
+    
     copy_array(arr, temp, size);
     
-    clock_t start = clock();
+    // Wall-clock time: clock() would add up the CPU time of every thread
+    double start = wall_time();
     
     switch (choice) {
         case 1:
@@ -141,14 +1215,29 @@ int main() {
             printf("\nUsing Randomized Quick Sort:\n");
             randomized_quick_sort(temp, 0, size - 1);
             break;
+        case 4:
+            printf("\nUsing Introsort:\n");
+            introsort(temp, 0, size - 1);
+            break;
+        case 5:
+            printf("\nUsing Three-way Quick Sort:\n");
+            quick_sort_3way(temp, 0, size - 1);
+            break;
+        case 6:
+            printf("\nUsing Block Quick Sort:\n");
+            block_quick_sort(temp, 0, size - 1);
+            break;
+        case 8:
+            printf("\nUsing Parallel Quick Sort with %d threads:\n", num_threads);
+            parallel_quick_sort(temp, 0, size - 1, num_threads);
+            break;
         default:
             printf("\nInvalid choice! Using standard Quick Sort.\n");
             quick_sort(temp, 0, size - 1);
             break;
     }
     
-    clock_t end = clock();
-    double time_taken = ((double)(end - start)) / CLOCKS_PER_SEC;
+    double time_taken = wall_time() - start;
     
     printf("Sorted array: ");
     print_array(temp, size);
@@ -158,3 +1247,4 @@ int main() {
     free(temp);
     return 0;
 }
+#endif
@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+
+#define MSD_DIGIT_BITS 8             // American flag sort splits on bytes
+#define MSD_INSERTION_THRESHOLD 32   // Buckets this small use insertion sort
+#define PRINT_LIMIT 100              // Arrays longer than this are printed truncated
+
+// Operation counters for SortBenchmark. With -DSORT_STATS the key
+// comparisons made by the MSD insertion sort leaves are counted in globals
+// that the harness defines; otherwise the hook compiles to nothing.
+#ifdef SORT_STATS
+extern long long sort_comparisons;
+#define COUNT_COMPARISON() (sort_comparisons++)
+#else
+#define COUNT_COMPARISON() ((void)0)
+#endif
+
+// Radix sort engines for one integer type.
+// DEFINE_RADIX_SORT(name, type, utype) expands to
+//   void name##_lsd(type arr[], int n, int digit_bits);  // stable, O(n) extra
+//   void name##_msd(type arr[], int n);                  // in place
+// where utype is the unsigned type of the same width. Keys are mapped to
+// utype with the sign bit flipped so negative values order first.
+//
+// LSD: all digit histograms are built in one pass over the input, then each
+// digit is scattered between the array and a buffer. Digits on which every
+// key agrees (e.g. the high bytes of small values) are skipped.
+//
+// MSD (American flag sort): counts the top byte, permutes keys into their
+// buckets in place by following cycles, then recurses into each bucket on
+// the next byte. Small buckets are finished with insertion sort.
+#define DEFINE_RADIX_SORT(name, type, utype)                                   \
+utype name##_key(type value) {                                                 \
+    return (utype)value ^ ((utype)1 << (sizeof(type) * 8 - 1));                \
+}                                                                              \
+                                                                               \
+void name##_lsd(type arr[], int n, int digit_bits) {                           \
+    int key_bits = sizeof(type) * 8;                                           \
+    int passes = (key_bits + digit_bits - 1) / digit_bits;                     \
+    int buckets = 1 << digit_bits;                                             \
+    utype mask = (utype)buckets - 1;                                           \
+                                                                               \
+    if (n < 2)                                                                 \
+        return;                                                                \
+                                                                               \
+    int *counts = calloc((size_t)passes * buckets, sizeof(int));               \
+    type *buffer = malloc(n * sizeof(type));                                   \
+    if (!counts || !buffer) {                                                  \
+        printf("Memory allocation failed!\n");                                 \
+        exit(1);                                                               \
+    }                                                                          \
+                                                                               \
+    /* Histograms of every digit in a single pass */                          \
+    for (int i = 0; i < n; i++) {                                              \
+        utype key = name##_key(arr[i]);                                        \
+        for (int p = 0; p < passes; p++)                                       \
+            counts[p * buckets + ((key >> (p * digit_bits)) & mask)]++;        \
+    }                                                                          \
+                                                                               \
+    type *src = arr, *dst = buffer;                                            \
+    utype first_key = name##_key(arr[0]);                                      \
+    for (int p = 0; p < passes; p++) {                                         \
+        int shift = p * digit_bits;                                            \
+        int *count = counts + p * buckets;                                     \
+                                                                               \
+        /* All keys share this digit: the pass would not move anything */     \
+        if (count[(first_key >> shift) & mask] == n)                           \
+            continue;                                                          \
+                                                                               \
+        /* Turn counts into starting offsets */                               \
+        int offset = 0;                                                        \
+        for (int b = 0; b < buckets; b++) {                                    \
+            int c = count[b];                                                  \
+            count[b] = offset;                                                 \
+            offset += c;                                                       \
+        }                                                                      \
+                                                                               \
+        for (int i = 0; i < n; i++) {                                          \
+            utype key = name##_key(src[i]);                                    \
+            dst[count[(key >> shift) & mask]++] = src[i];                      \
+        }                                                                      \
+                                                                               \
+        type *swap_ptr = src;                                                  \
+        src = dst;                                                             \
+        dst = swap_ptr;                                                        \
+    }                                                                          \
+                                                                               \
+    /* An odd number of scatter passes leaves the result in the buffer */     \
+    if (src != arr)                                                            \
+        memcpy(arr, src, n * sizeof(type));                                    \
+                                                                               \
+    free(counts);                                                              \
+    free(buffer);                                                              \
+}                                                                              \
+                                                                               \
+void name##_insertion_sort(type arr[], int low, int high) {                    \
+    for (int i = low + 1; i <= high; i++) {                                    \
+        type value = arr[i];                                                   \
+        int j = i - 1;                                                         \
+                                                                               \
+        while (j >= low && (COUNT_COMPARISON(), arr[j] > value)) {             \
+            arr[j + 1] = arr[j];                                               \
+            j--;                                                               \
+        }                                                                      \
+        arr[j + 1] = value;                                                    \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name##_msd_range(type arr[], int low, int high, int shift) {              \
+    int count[1 << MSD_DIGIT_BITS] = {0};                                      \
+    int next[1 << MSD_DIGIT_BITS];                                             \
+    int end[1 << MSD_DIGIT_BITS];                                              \
+    utype mask = (1 << MSD_DIGIT_BITS) - 1;                                    \
+                                                                               \
+    if (high - low + 1 <= MSD_INSERTION_THRESHOLD) {                           \
+        name##_insertion_sort(arr, low, high);                                 \
+        return;                                                                \
+    }                                                                          \
+                                                                               \
+    for (int i = low; i <= high; i++)                                          \
+        count[(name##_key(arr[i]) >> shift) & mask]++;                         \
+                                                                               \
+    int offset = low;                                                          \
+    for (int b = 0; b <= (int)mask; b++) {                                     \
+        next[b] = offset;                                                      \
+        offset += count[b];                                                    \
+        end[b] = offset;                                                       \
+    }                                                                          \
+                                                                               \
+    /* Skip the permutation when every key shares this digit */              \
+    if (count[(name##_key(arr[low]) >> shift) & mask] != high - low + 1) {     \
+        for (int b = 0; b <= (int)mask; b++) {                                 \
+            while (next[b] < end[b]) {                                         \
+                type value = arr[next[b]];                                     \
+                int digit = (name##_key(value) >> shift) & mask;               \
+                                                                               \
+                /* Follow the cycle until a key for bucket b turns up */      \
+                while (digit != b) {                                           \
+                    type displaced = arr[next[digit]];                         \
+                    arr[next[digit]++] = value;                                \
+                    value = displaced;                                         \
+                    digit = (name##_key(value) >> shift) & mask;               \
+                }                                                              \
+                arr[next[b]++] = value;                                        \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    if (shift == 0)                                                            \
+        return;                                                                \
+                                                                               \
+    int start = low;                                                           \
+    for (int b = 0; b <= (int)mask; b++) {                                     \
+        if (end[b] - start > 1)                                                \
+            name##_msd_range(arr, start, end[b] - 1, shift - MSD_DIGIT_BITS);  \
+        start = end[b];                                                        \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void name##_msd(type arr[], int n) {                                           \
+    if (n < 2)                                                                 \
+        return;                                                                \
+    name##_msd_range(arr, 0, n - 1, sizeof(type) * 8 - MSD_DIGIT_BITS);        \
+}
+
+// 32-bit keys: radix_sort_lsd, radix_sort_msd
+// 64-bit keys: radix_sort_i64_lsd, radix_sort_i64_msd
+DEFINE_RADIX_SORT(radix_sort, int, unsigned int)
+DEFINE_RADIX_SORT(radix_sort_i64, long long, unsigned long long)
+
+// SortBenchmark builds this file with -DSORT_NO_MAIN and calls the sorts
+// itself; the menu and its helpers below are left out
+#ifndef SORT_NO_MAIN
+
+static void print_array(int arr[], int size) {
+    int shown = (size > PRINT_LIMIT) ? PRINT_LIMIT : size;
+    for (int i = 0; i < shown; i++) {
+        printf("%d ", arr[i]);
+    }
+    if (shown < size) {
+        printf("... (%d more)", size - shown);
+    }
+    printf("\n");
+}
+
+static void copy_array(int source[], int dest[], int size) {
+    for (int i = 0; i < size; i++) {
+        dest[i] = source[i];
+    }
+}
+
+// Function to generate random array for testing
+static void generate_random_array(int arr[], int size, int max_val) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = rand() % max_val;
+    }
+}
+
+// Generate random keys over the full signed 32-bit range
+static void generate_full_range_array(int arr[], int size) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = (int)(((unsigned int)rand() << 16) ^ (unsigned int)rand() ^
+                       ((unsigned int)rand() << 31));
+    }
+}
+
+static int is_sorted(int arr[], int size) {
+    for (int i = 1; i < size; i++) {
+        if (arr[i - 1] > arr[i])
+            return 0;
+    }
+    return 1;
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int main() {
+    srand(time(NULL));
+    
+    int size, choice, input_choice;
+    
+    printf("Enter array size: ");
+    scanf("%d", &size);
+    
+    int *arr = malloc(size * sizeof(int));
+    int *temp = malloc(size * sizeof(int));
+    long long *wide = malloc(size * sizeof(long long));
+    
+    if (!arr || !temp || !wide) {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+    
+    printf("\nChoose input method:\n");
+    printf("1. Manual input\n");
+    printf("2. Random generation\n");
+    printf("3. Random full-range 32-bit keys\n");
+    printf("Enter choice (1-3): ");
+    scanf("%d", &input_choice);
+    
+    if (input_choice == 1) {
+        printf("Enter %d elements:\n", size);
+        for (int i = 0; i < size; i++) {
+            scanf("%d", &arr[i]);
+        }
+    } else if (input_choice == 3) {
+        generate_full_range_array(arr, size);
+        printf("Generated random array:\n");
+    } else {
+        generate_random_array(arr, size, 1000);
+        printf("Generated random array:\n");
+    }
+    
+    printf("\nOriginal array: ");
+    print_array(arr, size);
+    
+    printf("\nChoose Radix Sort variant:\n");
+    printf("1. LSD Radix Sort (8-bit digits)\n");
+    printf("2. LSD Radix Sort (11-bit digits)\n");
+    printf("3. LSD Radix Sort (16-bit digits)\n");
+    printf("4. MSD Radix Sort (in-place American flag sort)\n");
+    printf("5. Compare all methods\n");
+    printf("Enter choice (1-5): ");
+    scanf("%d", &choice);
+    
+    clock_t start, end;
+    
+    switch (choice) {
+        case 1:
+        case 2:
+        case 3: {
+            int digit_bits = (choice == 1) ? 8 : (choice == 2) ? 11 : 16;
+            copy_array(arr, temp, size);
+            start = clock();
+            radix_sort_lsd(temp, size, digit_bits);
+            end = clock();
+            
+            printf("\nUsing LSD Radix Sort (%d-bit digits):\n", digit_bits);
+            printf("Sorted array: ");
+            print_array(temp, size);
+            printf("Time taken: %f seconds\n", ((double)(end - start)) / CLOCKS_PER_SEC);
+            break;
+        }
+            
+        case 4:
+            copy_array(arr, temp, size);
+            start = clock();
+            radix_sort_msd(temp, size);
+            end = clock();
+            
+            printf("\nUsing MSD Radix Sort:\n");
+            printf("Sorted array: ");
+            print_array(temp, size);
+            printf("Time taken: %f seconds\n", ((double)(end - start)) / CLOCKS_PER_SEC);
+            break;
+            
+        case 5: {
+            const char *names[] = {
+                "LSD 8-bit digits", "LSD 11-bit digits", "LSD 16-bit digits",
+                "MSD American flag", "LSD 64-bit keys, 11-bit", "MSD 64-bit keys",
+                "libc qsort"
+            };
+            
+            printf("\nComparison Results:\n");
+            for (int v = 0; v < 7; v++) {
+                copy_array(arr, temp, size);
+                for (int i = 0; i < size; i++)
+                    wide[i] = arr[i];
+                
+                start = clock();
+                switch (v) {
+                    case 0: radix_sort_lsd(temp, size, 8); break;
+                    case 1: radix_sort_lsd(temp, size, 11); break;
+                    case 2: radix_sort_lsd(temp, size, 16); break;
+                    case 3: radix_sort_msd(temp, size); break;
+                    case 4: radix_sort_i64_lsd(wide, size, 11); break;
+                    case 5: radix_sort_i64_msd(wide, size); break;
+                    default: qsort(temp, size, sizeof(int), compare_ints); break;
+                }
+                end = clock();
+                
+                // The 64-bit runs are checked through a narrowed copy
+                if (v == 4 || v == 5) {
+                    for (int i = 0; i < size; i++)
+                        temp[i] = (int)wide[i];
+                }
+                printf("%-26s %f seconds%s\n", names[v],
+                       ((double)(end - start)) / CLOCKS_PER_SEC,
+                       is_sorted(temp, size) ? "" : "  (NOT SORTED)");
+            }
+            printf("Sorted array: ");
+            print_array(temp, size);
+            break;
+        }
+            
+        default:
+            printf("\nInvalid choice! Using LSD radix sort.\n");
+            copy_array(arr, temp, size);
+            radix_sort_lsd(temp, size, 8);
+            printf("Sorted array: ");
+            print_array(temp, size);
+            break;
+    }
+    
+    free(arr);
+    free(temp);
+    free(wide);
+    return 0;
+}
+#endif
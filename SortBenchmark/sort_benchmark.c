@@ -0,0 +1,612 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../PerfCounters/perf_counters.h"
+#include "../SortingNetwork/sorting_network.h"
+
+#define MAX_SIZES 32
+#define ZIPF_MAX_KEYS (1 << 20)     // Distinct keys drawn by the Zipf distribution
+#define FEW_UNIQUE_KEYS 16          // Distinct keys in the few-unique distribution
+#define QUADRATIC_LIMIT 50000       // Default largest n for worst-case quadratic sorts
+#define NUM_NETWORK_LEVELS (SORT_NETWORK_AVX2 + 1)
+
+// Counters the sort files bump when built with -DSORT_STATS
+long long sort_comparisons = 0;
+long long sort_swaps = 0;
+
+#ifdef SORT_STATS
+#define STATS_ENABLED 1
+#else
+#define STATS_ENABLED 0
+#endif
+
+// Sorts from the sibling directories, linked in with -DSORT_NO_MAIN
+void quick_sort(int arr[], int low, int high);
+void quick_sort_hoare(int arr[], int low, int high);
+void randomized_quick_sort(int arr[], int low, int high);
+void introsort(int arr[], int low, int high);
+void quick_sort_3way(int arr[], int low, int high);
+void block_quick_sort(int arr[], int low, int high);
+void merge_sort(int arr[], int left, int right);
+void merge_sort_iterative(int arr[], int n);
+void tim_sort(int arr[], int n);
+void heap_sort_ascending(int arr[], int n);
+void heap_sort_descending(int arr[], int n);
+void heap_sort_ascending_floyd(int arr[], int n);
+void radix_sort_lsd(int arr[], int n, int digit_bits);
+void radix_sort_msd(int arr[], int n);
+
+// Every variant is run through the same (arr, n) signature
+void run_quick_lomuto(int arr[], int n) { quick_sort(arr, 0, n - 1); }
+void run_quick_hoare(int arr[], int n) { quick_sort_hoare(arr, 0, n - 1); }
+void run_quick_randomized(int arr[], int n) { randomized_quick_sort(arr, 0, n - 1); }
+void run_introsort(int arr[], int n) { introsort(arr, 0, n - 1); }
+void run_quick_3way(int arr[], int n) { quick_sort_3way(arr, 0, n - 1); }
+void run_block_quick(int arr[], int n) { block_quick_sort(arr, 0, n - 1); }
+void run_merge_recursive(int arr[], int n) { merge_sort(arr, 0, n - 1); }
+void run_radix_lsd(int arr[], int n) { radix_sort_lsd(arr, n, 8); }
+
+int compare_ints(const void *a, const void *b) {
+#ifdef SORT_STATS
+    sort_comparisons++;
+#endif
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+void run_qsort(int arr[], int n) { qsort(arr, n, sizeof(int), compare_ints); }
+
+typedef struct {
+    const char *name;
+    void (*sort)(int arr[], int n);
+    int descending;  // Produces descending order
+    int quadratic;   // O(n^2) on presorted or duplicate-heavy input
+    int counts_swaps;
+    int uses_network; // Small ranges go to SortingNetwork/; run once per --network level
+} SortVariant;
+
+SortVariant variants[] = {
+    {"quick_lomuto",     run_quick_lomuto,          0, 1, 1, 1},
+    {"quick_hoare",      run_quick_hoare,           0, 1, 1, 1},
+    {"quick_randomized", run_quick_randomized,      0, 1, 1, 1},
+    {"introsort",        run_introsort,             0, 0, 1, 1},
+    {"quick_3way",       run_quick_3way,            0, 0, 1, 1},
+    {"block_quick",      run_block_quick,           0, 0, 1, 0},
+    {"merge_recursive",  run_merge_recursive,       0, 0, 1, 1},
+    {"merge_iterative",  merge_sort_iterative,      0, 0, 1, 1},
+    {"tim_sort",         tim_sort,                  0, 0, 1, 0},
+    {"heap_asc",         heap_sort_ascending,       0, 0, 1, 0},
+    {"heap_desc",        heap_sort_descending,      1, 0, 1, 0},
+    {"heap_asc_floyd",   heap_sort_ascending_floyd, 0, 0, 1, 0},
+    {"radix_lsd",        run_radix_lsd,             0, 0, 1, 0},
+    {"radix_msd",        radix_sort_msd,            0, 0, 1, 0},
+    {"qsort",            run_qsort,                 0, 0, 0, 0},
+};
+
+#define NUM_VARIANTS ((int)(sizeof(variants) / sizeof(variants[0])))
+
+// Input distributions. Only "random" is safe for the quadratic variants.
+typedef enum {
+    DIST_RANDOM,
+    DIST_SORTED,
+    DIST_REVERSED,
+    DIST_ORGAN_PIPE,
+    DIST_FEW_UNIQUE,
+    DIST_ZIPF,
+    NUM_DISTRIBUTIONS
+} Distribution;
+
+const char *distribution_names[NUM_DISTRIBUTIONS] = {
+    "random", "sorted", "reversed", "organ_pipe", "few_unique", "zipf"
+};
+
+// splitmix64: small, fast and good enough to seed reproducible inputs
+unsigned long long next_random(unsigned long long *state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Zipf(1) over min(n, ZIPF_MAX_KEYS) keys, sampled from the inverse CDF.
+// Ranks are scattered over the int range so hot keys are not the smallest.
+void generate_zipf(int arr[], int n, unsigned long long *state) {
+    int keys = (n < ZIPF_MAX_KEYS) ? n : ZIPF_MAX_KEYS;
+    double *cdf = malloc(keys * sizeof(double));
+    if (!cdf) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+    double total = 0.0;
+    for (int r = 0; r < keys; r++) {
+        total += 1.0 / (r + 1);
+        cdf[r] = total;
+    }
+
+    for (int i = 0; i < n; i++) {
+        double u = (next_random(state) >> 11) * (1.0 / 9007199254740992.0) * total;
+        int lo = 0, hi = keys - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (cdf[mid] < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        arr[i] = (int)((unsigned int)lo * 2654435761u);
+    }
+    free(cdf);
+}
+
+void generate_input(int arr[], int n, Distribution dist, unsigned long long seed) {
+    unsigned long long state = seed;
+
+    switch (dist) {
+        case DIST_RANDOM:
+            for (int i = 0; i < n; i++)
+                arr[i] = (int)next_random(&state);
+            break;
+        case DIST_SORTED:
+            for (int i = 0; i < n; i++)
+                arr[i] = i;
+            break;
+        case DIST_REVERSED:
+            for (int i = 0; i < n; i++)
+                arr[i] = n - i;
+            break;
+        case DIST_ORGAN_PIPE:
+            for (int i = 0; i < n; i++)
+                arr[i] = (i < n / 2) ? i : n - i;
+            break;
+        case DIST_FEW_UNIQUE:
+            for (int i = 0; i < n; i++)
+                arr[i] = (int)(next_random(&state) % FEW_UNIQUE_KEYS);
+            break;
+        default:
+            generate_zipf(arr, n, &state);
+            break;
+    }
+}
+
+double monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Sorted result equals the qsort reference (read backwards if descending)
+int matches_reference(int arr[], int reference[], int n, int descending) {
+    if (!descending)
+        return memcmp(arr, reference, n * sizeof(int)) == 0;
+    for (int i = 0; i < n; i++) {
+        if (arr[i] != reference[n - 1 - i])
+            return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    long long sizes[MAX_SIZES];
+    int num_sizes;
+    int use_dist[NUM_DISTRIBUTIONS];
+    int use_sort[NUM_VARIANTS];
+    int use_network[NUM_NETWORK_LEVELS];
+    int reps;
+    unsigned long long seed;
+    int json;
+    long long quadratic_limit;
+} BenchmarkConfig;
+
+typedef struct {
+    const char *status;    // "ok", "FAILED" or "skipped"
+    double mean, stddev, min;  // ns per element over the repetitions
+    double comparisons, swaps; // Mean per run
+} BenchmarkResult;
+
+int result_count = 0;
+
+#ifdef PERF_COUNTERS
+// Hardware counters of one call site for one measurement, per run
+typedef struct {
+    const char *sort;
+    const char *network;
+    const char *dist;
+    long long n;
+    const char *site;
+    double calls;
+    double values[PERF_NUM_EVENTS];
+} PerfRow;
+
+PerfRow *perf_rows = NULL;
+int perf_row_count = 0;
+int perf_row_capacity = 0;
+
+// Collects the sites entered during the last measurement. JSON output nests
+// them in the result object; CSV output prints them as a second table at
+// the end, so the main table keeps one schema.
+void record_perf(BenchmarkConfig *config, const char *sort, const char *network,
+                 const char *dist, long long n) {
+    int first = 1;
+
+    if (config->json)
+        printf(", \"perf\": [");
+    for (PerfSite *site = perf_sites(); site; site = site->next) {
+        if (site->calls == 0)
+            continue;
+
+        PerfRow row = {sort, network, dist, n, site->name, (double)site->calls / config->reps, {0}};
+        for (int e = 0; e < PERF_NUM_EVENTS; e++)
+            row.values[e] = (double)site->totals[e] / config->reps;
+
+        if (config->json) {
+            printf("%s{\"site\": \"%s\", \"calls\": %.0f", first ? "" : ", ", row.site, row.calls);
+            for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+                if (perf_event_available(e))
+                    printf(", \"%s\": %.0f", perf_event_name(e), row.values[e]);
+                else
+                    printf(", \"%s\": null", perf_event_name(e));
+            }
+            printf("}");
+            first = 0;
+            continue;
+        }
+
+        if (perf_row_count == perf_row_capacity) {
+            perf_row_capacity = perf_row_capacity ? 2 * perf_row_capacity : 64;
+            perf_rows = realloc(perf_rows, perf_row_capacity * sizeof(PerfRow));
+            if (!perf_rows) {
+                printf("Memory allocation failed!\n");
+                exit(1);
+            }
+        }
+        perf_rows[perf_row_count++] = row;
+    }
+    if (config->json)
+        printf("]");
+}
+
+void print_perf_table(void) {
+    printf("\nsort,network,distribution,n,site,calls");
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+        printf(",%s", perf_event_name(e));
+    printf("\n");
+
+    for (int i = 0; i < perf_row_count; i++) {
+        PerfRow *row = &perf_rows[i];
+        printf("%s,%s,%s,%lld,%s,%.0f", row->sort, row->network ? row->network : "",
+               row->dist, row->n, row->site, row->calls);
+        for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+            if (perf_event_available(e))
+                printf(",%.0f", row->values[e]);
+            else
+                printf(",");
+        }
+        printf("\n");
+    }
+}
+#endif
+
+// network is the SortingNetwork level the sort ran with, or NULL if it uses none
+void print_result(BenchmarkConfig *config, const char *sort, const char *network,
+                  const char *dist, long long n, BenchmarkResult *r) {
+    int ran = strcmp(r->status, "skipped") != 0;
+    int swaps_known = ran && STATS_ENABLED && r->swaps >= 0;
+
+    if (config->json) {
+        printf("%s\n  {\"sort\": \"%s\", ", result_count ? "," : "", sort);
+        if (network)
+            printf("\"network\": \"%s\", ", network);
+        else
+            printf("\"network\": null, ");
+        printf("\"distribution\": \"%s\", \"n\": %lld, \"reps\": %d, ",
+               dist, n, ran ? config->reps : 0);
+        if (ran)
+            printf("\"ns_per_elem_mean\": %.4f, \"ns_per_elem_stddev\": %.4f, \"ns_per_elem_min\": %.4f, ",
+                   r->mean, r->stddev, r->min);
+        else
+            printf("\"ns_per_elem_mean\": null, \"ns_per_elem_stddev\": null, \"ns_per_elem_min\": null, ");
+        if (ran && STATS_ENABLED)
+            printf("\"comparisons\": %.0f, ", r->comparisons);
+        else
+            printf("\"comparisons\": null, ");
+        if (swaps_known)
+            printf("\"swaps\": %.0f, ", r->swaps);
+        else
+            printf("\"swaps\": null, ");
+        printf("\"status\": \"%s\"", r->status);
+#ifdef PERF_COUNTERS
+        if (ran)
+            record_perf(config, sort, network, dist, n);
+#endif
+        printf("}");
+    } else {
+        printf("%s,%s,%s,%lld,%d,", sort, network ? network : "", dist, n,
+               ran ? config->reps : 0);
+        if (ran)
+            printf("%.4f,%.4f,%.4f,", r->mean, r->stddev, r->min);
+        else
+            printf(",,,");
+        if (ran && STATS_ENABLED)
+            printf("%.0f", r->comparisons);
+        printf(",");
+        if (swaps_known)
+            printf("%.0f", r->swaps);
+        printf(",%s\n", r->status);
+#ifdef PERF_COUNTERS
+        if (ran)
+            record_perf(config, sort, network, dist, n);
+#endif
+    }
+    fflush(stdout);
+    result_count++;
+}
+
+// Times config->reps sorts of fresh copies of input[0..n-1] into result
+void measure(BenchmarkConfig *config, SortVariant *variant, int input[], int work[],
+             int reference[], double samples[], int n, BenchmarkResult *result) {
+    long long comparisons = 0, swaps = 0;
+
+    perf_counters_reset();
+    for (int rep = 0; rep < config->reps; rep++) {
+        memcpy(work, input, n * sizeof(int));
+        srand((unsigned int)(config->seed + rep));  // Randomized pivots
+        sort_comparisons = 0;
+        sort_swaps = 0;
+
+        double start = monotonic_ns();
+        variant->sort(work, n);
+        samples[rep] = (monotonic_ns() - start) / n;
+
+        comparisons += sort_comparisons;
+        swaps += sort_swaps;
+        if (!matches_reference(work, reference, n, variant->descending))
+            result->status = "FAILED";
+    }
+
+    double sum = 0.0, sum_sq = 0.0;
+    result->min = samples[0];
+    for (int rep = 0; rep < config->reps; rep++) {
+        sum += samples[rep];
+        if (samples[rep] < result->min)
+            result->min = samples[rep];
+    }
+    result->mean = sum / config->reps;
+    for (int rep = 0; rep < config->reps; rep++)
+        sum_sq += (samples[rep] - result->mean) * (samples[rep] - result->mean);
+    result->stddev = (config->reps > 1) ? sqrt(sum_sq / (config->reps - 1)) : 0.0;
+    result->comparisons = (double)comparisons / config->reps;
+    if (variant->counts_swaps)
+        result->swaps = (double)swaps / config->reps;
+}
+
+void run_benchmark(BenchmarkConfig *config) {
+    long long max_n = 0;
+    for (int s = 0; s < config->num_sizes; s++) {
+        if (config->sizes[s] > max_n)
+            max_n = config->sizes[s];
+    }
+
+    int *input = malloc(max_n * sizeof(int));
+    int *work = malloc(max_n * sizeof(int));
+    int *reference = malloc(max_n * sizeof(int));
+    double *samples = malloc(config->reps * sizeof(double));
+    if (!input || !work || !reference || !samples) {
+        printf("Memory allocation failed!\n");
+        exit(1);
+    }
+
+#ifdef PERF_COUNTERS
+    if (perf_counters_init() < PERF_NUM_EVENTS) {
+        fprintf(stderr, "Performance counters not available:");
+        for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+            if (!perf_event_available(e))
+                fprintf(stderr, " %s", perf_event_name(e));
+        }
+        fprintf(stderr, "\n");
+    }
+#endif
+
+    if (config->json)
+        printf("[");
+    else
+        printf("sort,network,distribution,n,reps,ns_per_elem_mean,ns_per_elem_stddev,"
+               "ns_per_elem_min,comparisons,swaps,status\n");
+
+    for (int s = 0; s < config->num_sizes; s++) {
+        int n = (int)config->sizes[s];
+
+        for (int d = 0; d < NUM_DISTRIBUTIONS; d++) {
+            if (!config->use_dist[d])
+                continue;
+
+            // Same seed for every sort, so all variants see identical input
+            generate_input(input, n, d, config->seed ^ ((unsigned long long)n << 8) ^ d);
+            memcpy(reference, input, n * sizeof(int));
+            qsort(reference, n, sizeof(int), compare_ints);
+
+            for (int v = 0; v < NUM_VARIANTS; v++) {
+                SortVariant *variant = &variants[v];
+
+                if (!config->use_sort[v])
+                    continue;
+
+                // Sorts without a network leaf run once, whatever the levels
+                for (int level = 0; level < NUM_NETWORK_LEVELS; level++) {
+                    const char *network = NULL;
+                    BenchmarkResult result = {"ok", 0, 0, 0, 0, -1};
+
+                    if (variant->uses_network) {
+                        if (!config->use_network[level])
+                            continue;
+                        network = sort_network_name(sort_network_select(level));
+                    } else if (level > 0) {
+                        break;
+                    }
+
+                    if (variant->quadratic && d != DIST_RANDOM && n > config->quadratic_limit)
+                        result.status = "skipped";
+                    else
+                        measure(config, variant, input, work, reference, samples, n, &result);
+                    print_result(config, variant->name, network, distribution_names[d], n, &result);
+                }
+            }
+        }
+    }
+
+    if (config->json)
+        printf("\n]\n");
+#ifdef PERF_COUNTERS
+    else
+        print_perf_table();
+    free(perf_rows);
+    perf_counters_close();
+#endif
+
+    free(input);
+    free(work);
+    free(reference);
+    free(samples);
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --sizes N,N,...     Array sizes, e.g. 1e3,1e4,1e8 (default 1e3,1e4,1e5,1e6)\n");
+    printf("  --dists D,D,...     random, sorted, reversed, organ_pipe, few_unique, zipf (default all)\n");
+    printf("  --sorts S,S,...     Sort variants (default all):\n                     ");
+    for (int v = 0; v < NUM_VARIANTS; v++)
+        printf(" %s", variants[v].name);
+    printf("\n");
+    printf("  --reps R            Repetitions per measurement (default 5)\n");
+    printf("  --seed S            Seed of the input generator (default 42)\n");
+    printf("  --format csv|json   Output format (default csv)\n");
+    printf("  --network L,L,...   Sorting network levels for the sorts with network leaves:\n");
+    printf("                      off, scalar, sse4.1, avx2, auto (default auto = %s)\n",
+           sort_network_name(sort_network_detect()));
+    printf("  --quadratic-limit N Largest n for the quadratic quick sorts on non-random\n");
+    printf("                      input; larger runs are reported as skipped (default %d)\n",
+           QUADRATIC_LIMIT);
+}
+
+// Marks every comma-separated name of list in selected[]; -1 on an unknown name
+int parse_names(char *list, const char *names[], int count, int selected[]) {
+    memset(selected, 0, count * sizeof(int));
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ",")) {
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            if (strcmp(token, names[i]) == 0) {
+                selected[i] = 1;
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown name: %s\n", token);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Levels above what the CPU supports are dropped with a warning
+int parse_networks(char *list, BenchmarkConfig *config) {
+    const char *names[NUM_NETWORK_LEVELS + 1];
+    int selected[NUM_NETWORK_LEVELS + 1];
+    SortNetworkLevel best = sort_network_detect();
+
+    for (int level = 0; level < NUM_NETWORK_LEVELS; level++)
+        names[level] = sort_network_name(level);
+    names[NUM_NETWORK_LEVELS] = "auto";
+    if (parse_names(list, names, NUM_NETWORK_LEVELS + 1, selected) < 0)
+        return -1;
+
+    memset(config->use_network, 0, sizeof(config->use_network));
+    if (selected[NUM_NETWORK_LEVELS])
+        config->use_network[best] = 1;
+    for (int level = 0; level < NUM_NETWORK_LEVELS; level++) {
+        if (selected[level] && level > (int)best)
+            fprintf(stderr, "Sorting network %s not supported on this CPU\n", names[level]);
+        else if (selected[level])
+            config->use_network[level] = 1;
+    }
+    return 0;
+}
+
+int parse_sizes(char *list, BenchmarkConfig *config) {
+    config->num_sizes = 0;
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ",")) {
+        double value = strtod(token, NULL);  // Accepts 1e8 as well as 100000000
+        if (value < 1 || value > 2147483647.0 || config->num_sizes == MAX_SIZES) {
+            fprintf(stderr, "Invalid size: %s\n", token);
+            return -1;
+        }
+        config->sizes[config->num_sizes++] = (long long)value;
+    }
+    return config->num_sizes > 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    BenchmarkConfig config = {
+        .sizes = {1000, 10000, 100000, 1000000},
+        .num_sizes = 4,
+        .reps = 5,
+        .seed = 42,
+        .json = 0,
+        .quadratic_limit = QUADRATIC_LIMIT,
+    };
+    const char *sort_names[NUM_VARIANTS];
+
+    for (int d = 0; d < NUM_DISTRIBUTIONS; d++)
+        config.use_dist[d] = 1;
+    config.use_network[sort_network_detect()] = 1;
+    for (int v = 0; v < NUM_VARIANTS; v++) {
+        config.use_sort[v] = 1;
+        sort_names[v] = variants[v].name;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int error = 0;
+
+        if (strcmp(opt, "--help") == 0 || strcmp(opt, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (!value) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (strcmp(opt, "--sizes") == 0)
+            error = parse_sizes(value, &config);
+        else if (strcmp(opt, "--dists") == 0)
+            error = parse_names(value, distribution_names, NUM_DISTRIBUTIONS, config.use_dist);
+        else if (strcmp(opt, "--sorts") == 0)
+            error = parse_names(value, sort_names, NUM_VARIANTS, config.use_sort);
+        else if (strcmp(opt, "--reps") == 0)
+            error = (config.reps = atoi(value)) < 1;
+        else if (strcmp(opt, "--seed") == 0)
+            config.seed = strtoull(value, NULL, 10);
+        else if (strcmp(opt, "--format") == 0 && strcmp(value, "csv") == 0)
+            config.json = 0;
+        else if (strcmp(opt, "--format") == 0 && strcmp(value, "json") == 0)
+            config.json = 1;
+        else if (strcmp(opt, "--network") == 0)
+            error = parse_networks(value, &config);
+        else if (strcmp(opt, "--quadratic-limit") == 0)
+            config.quadratic_limit = (long long)strtod(value, NULL);
+        else
+            error = 1;
+
+        if (error) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    run_benchmark(&config);
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include <limits.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "sorting_network.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SORT_NETWORK_X86 1
+#include <immintrin.h>
+#else
+#define SORT_NETWORK_X86 0
+#endif
+
+#define NETWORK_INLINE static inline __attribute__((always_inline))
+
+// Bitonic sort over `count` registers of W lanes each, count * W a power of
+// two. DEFINE_BITONIC_NETWORK(isa, vec, W, target) expands to
+//   void isa##_bitonic_merge(vec v[], int count); // both halves sorted
+//   void isa##_bitonic_sort(vec v[], int count);
+//   void isa##_sort(int arr[], int n);             // n <= SORT_NETWORK_MAX
+//   void isa##_merge_runs(const int a[], int na, const int b[], int nb, int dst[]);
+// built from the primitives isa##_min, isa##_max, isa##_reverse (lane order),
+// isa##_load, isa##_store, isa##_flip_in(v, k) and isa##_half_in(v, j).
+//
+// Every comparator puts the minimum at the lower index. Stage k first
+// compares i with i ^ (k - 1) (the "flip", which turns two sorted halves
+// into a bitonic sequence without a descending pass), then runs half
+// cleaners comparing i with i ^ j for j = k/4 .. 1. Distances of a register
+// or more pair whole registers with min/max; shorter ones are in-register
+// shuffles, done by flip_in/half_in. count is a constant at every call
+// site, so the loops unroll into straight-line code.
+//
+// isa##_sort pads the array to count * W lanes with INT_MAX. isa##_merge_runs
+// is the merge of Inoue et al.: each step bitonic-merges the W held
+// elements with the next W from the run whose head is smaller, stores the
+// lower W and keeps the upper W; the tail is merged with scalar code.
+#define DEFINE_BITONIC_NETWORK(isa, vec, W, target)                            \
+target NETWORK_INLINE void isa##_flip(vec v[], int count, int k) {             \
+    if (k <= W) {                                                              \
+        for (int r = 0; r < count; r++)                                        \
+            v[r] = isa##_flip_in(v[r], k);                                     \
+        return;                                                                \
+    }                                                                          \
+    int block = k / W;                                                         \
+    for (int b = 0; b < count; b += block) {                                   \
+        for (int t = 0; t < block / 2; t++) {                                  \
+            vec lo = v[b + t];                                                 \
+            vec hi = isa##_reverse(v[b + block - 1 - t]);                      \
+            v[b + t] = isa##_min(lo, hi);                                      \
+            v[b + block - 1 - t] = isa##_reverse(isa##_max(lo, hi));           \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+target NETWORK_INLINE void isa##_half(vec v[], int count, int j) {             \
+    if (j < W) {                                                               \
+        for (int r = 0; r < count; r++)                                        \
+            v[r] = isa##_half_in(v[r], j);                                     \
+        return;                                                                \
+    }                                                                          \
+    int step = j / W;                                                          \
+    for (int r = 0; r < count; r++) {                                          \
+        if (r & step)                                                          \
+            continue;                                                          \
+        vec lo = v[r], hi = v[r + step];                                       \
+        v[r] = isa##_min(lo, hi);                                              \
+        v[r + step] = isa##_max(lo, hi);                                       \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+target NETWORK_INLINE void isa##_bitonic_merge(vec v[], int count) {           \
+    int k = count * W;                                                         \
+    isa##_flip(v, count, k);                                                   \
+    for (int j = k / 4; j >= 1; j /= 2)                                        \
+        isa##_half(v, count, j);                                               \
+}                                                                              \
+                                                                               \
+target NETWORK_INLINE void isa##_bitonic_sort(vec v[], int count) {            \
+    for (int k = 2; k <= count * W; k *= 2) {                                  \
+        isa##_flip(v, count, k);                                               \
+        for (int j = k / 4; j >= 1; j /= 2)                                    \
+            isa##_half(v, count, j);                                           \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+target NETWORK_INLINE void isa##_sort_count(int arr[], int n, int count) {     \
+    vec v[SORT_NETWORK_MAX / W];                                               \
+    int padded[SORT_NETWORK_MAX];                                              \
+    int *src = arr;                                                            \
+                                                                               \
+    if (n < count * W) {                                                       \
+        memcpy(padded, arr, n * sizeof(int));                                  \
+        for (int i = n; i < count * W; i++)                                    \
+            padded[i] = INT_MAX;                                               \
+        src = padded;                                                          \
+    }                                                                          \
+    for (int r = 0; r < count; r++)                                            \
+        v[r] = isa##_load(src + r * W);                                        \
+    isa##_bitonic_sort(v, count);                                              \
+    for (int r = 0; r < count; r++)                                            \
+        isa##_store(src + r * W, v[r]);                                        \
+    if (src != arr)                                                            \
+        memcpy(arr, padded, n * sizeof(int));                                  \
+}                                                                              \
+                                                                               \
+target void isa##_sort(int arr[], int n) {                                     \
+    /* One call per network size, so each is fully unrolled */                \
+    if (n <= W)                                                                \
+        isa##_sort_count(arr, n, 1);                                           \
+    else if (n <= 2 * W)                                                       \
+        isa##_sort_count(arr, n, 2);                                           \
+    else if (4 * W <= SORT_NETWORK_MAX && n <= 4 * W)                          \
+        isa##_sort_count(arr, n, 4);                                           \
+    else if (8 * W <= SORT_NETWORK_MAX && n <= 8 * W)                          \
+        isa##_sort_count(arr, n, 8);                                           \
+    else if (16 * W <= SORT_NETWORK_MAX && n <= 16 * W)                        \
+        isa##_sort_count(arr, n, 16);                                          \
+    else if (32 * W <= SORT_NETWORK_MAX)                                       \
+        isa##_sort_count(arr, n, 32);                                          \
+}                                                                              \
+                                                                               \
+target void isa##_merge_runs(const int a[], int na, const int b[], int nb,     \
+                             int dst[]) {                                      \
+    vec v[2] = {isa##_load(a), isa##_load(b)};                                 \
+    int i = W, j = W;                                                          \
+                                                                               \
+    while (1) {                                                                \
+        isa##_bitonic_merge(v, 2);                                             \
+        isa##_store(dst, v[0]);                                                \
+        dst += W;                                                              \
+        v[0] = v[1];                                                           \
+                                                                               \
+        /* Refill from the run with the smaller head, while it has a vector */ \
+        int take_a = i < na && (j >= nb || a[i] <= b[j]);                      \
+        if (take_a ? i + W > na : j + W > nb)                                  \
+            break;                                                             \
+        if (take_a) {                                                          \
+            v[1] = isa##_load(a + i);                                          \
+            i += W;                                                            \
+        } else {                                                               \
+            v[1] = isa##_load(b + j);                                          \
+            j += W;                                                            \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* Three-way merge of the held vector and what is left of both runs */    \
+    int held[W];                                                               \
+    int h = 0;                                                                 \
+    isa##_store(held, v[0]);                                                   \
+    while (h < W || i < na || j < nb) {                                        \
+        if (h < W && (i >= na || held[h] <= a[i]) &&                           \
+            (j >= nb || held[h] <= b[j]))                                      \
+            *dst++ = held[h++];                                                \
+        else if (i < na && (j >= nb || a[i] <= b[j]))                          \
+            *dst++ = a[i++];                                                   \
+        else                                                                   \
+            *dst++ = b[j++];                                                   \
+    }                                                                          \
+}
+
+// Scalar network: one int per "register", compiled to cmov
+#define scalar_min(a, b) ((a) < (b) ? (a) : (b))
+#define scalar_max(a, b) ((a) < (b) ? (b) : (a))
+#define scalar_reverse(v) (v)
+#define scalar_load(p) (*(p))
+#define scalar_store(p, v) (*(p) = (v))
+#define scalar_flip_in(v, k) (v)   // Never reached: every distance spans registers
+#define scalar_half_in(v, j) (v)
+
+DEFINE_BITONIC_NETWORK(scalar, int, 1, )
+
+#if SORT_NETWORK_X86
+
+#define SSE41 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+// Compare each lane with a permuted partner; lanes in `mask` keep the max
+#define SSE41_EXCHANGE(v, partner, mask16)                                     \
+    _mm_blend_epi16(_mm_min_epi32(v, partner), _mm_max_epi32(v, partner), mask16)
+#define AVX2_EXCHANGE(v, partner, mask8)                                       \
+    _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), mask8)
+
+SSE41 NETWORK_INLINE __m128i sse41_min(__m128i a, __m128i b) { return _mm_min_epi32(a, b); }
+SSE41 NETWORK_INLINE __m128i sse41_max(__m128i a, __m128i b) { return _mm_max_epi32(a, b); }
+SSE41 NETWORK_INLINE __m128i sse41_reverse(__m128i v) { return _mm_shuffle_epi32(v, 0x1B); }
+SSE41 NETWORK_INLINE __m128i sse41_load(const int *p) { return _mm_loadu_si128((const __m128i *)p); }
+SSE41 NETWORK_INLINE void sse41_store(int *p, __m128i v) { _mm_storeu_si128((__m128i *)p, v); }
+
+// Lane i against lane i ^ (k - 1)
+SSE41 NETWORK_INLINE __m128i sse41_flip_in(__m128i v, int k) {
+    if (k == 2)
+        return SSE41_EXCHANGE(v, _mm_shuffle_epi32(v, 0xB1), 0xCC);
+    return SSE41_EXCHANGE(v, _mm_shuffle_epi32(v, 0x1B), 0xF0);
+}
+
+// Lane i against lane i ^ j
+SSE41 NETWORK_INLINE __m128i sse41_half_in(__m128i v, int j) {
+    if (j == 1)
+        return SSE41_EXCHANGE(v, _mm_shuffle_epi32(v, 0xB1), 0xCC);
+    return SSE41_EXCHANGE(v, _mm_shuffle_epi32(v, 0x4E), 0xF0);
+}
+
+DEFINE_BITONIC_NETWORK(sse41, __m128i, 4, SSE41)
+
+AVX2 NETWORK_INLINE __m256i avx2_min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+AVX2 NETWORK_INLINE __m256i avx2_max(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+AVX2 NETWORK_INLINE __m256i avx2_load(const int *p) { return _mm256_loadu_si256((const __m256i *)p); }
+AVX2 NETWORK_INLINE void avx2_store(int *p, __m256i v) { _mm256_storeu_si256((__m256i *)p, v); }
+
+AVX2 NETWORK_INLINE __m256i avx2_reverse(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+AVX2 NETWORK_INLINE __m256i avx2_flip_in(__m256i v, int k) {
+    if (k == 2)
+        return AVX2_EXCHANGE(v, _mm256_shuffle_epi32(v, 0xB1), 0xAA);
+    if (k == 4)
+        return AVX2_EXCHANGE(v, _mm256_shuffle_epi32(v, 0x1B), 0xCC);
+    return AVX2_EXCHANGE(v, avx2_reverse(v), 0xF0);
+}
+
+AVX2 NETWORK_INLINE __m256i avx2_half_in(__m256i v, int j) {
+    if (j == 1)
+        return AVX2_EXCHANGE(v, _mm256_shuffle_epi32(v, 0xB1), 0xAA);
+    if (j == 2)
+        return AVX2_EXCHANGE(v, _mm256_shuffle_epi32(v, 0x4E), 0xCC);
+    return AVX2_EXCHANGE(v, _mm256_permute2x128_si256(v, v, 0x01), 0xF0);
+}
+
+DEFINE_BITONIC_NETWORK(avx2, __m256i, 8, AVX2)
+
+#endif
+
+atomic_int sort_network_current = -1;   // -1 until first use: detect
+
+// Best level this CPU supports
+SortNetworkLevel sort_network_detect(void) {
+#if SORT_NETWORK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SORT_NETWORK_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SORT_NETWORK_SSE41;
+#endif
+    return SORT_NETWORK_SCALAR;
+}
+
+SortNetworkLevel sort_network_level(void) {
+    int level = atomic_load_explicit(&sort_network_current, memory_order_relaxed);
+    if (level < 0) {
+        level = sort_network_detect();
+        atomic_store_explicit(&sort_network_current, level, memory_order_relaxed);
+    }
+    return level;
+}
+
+// Use `level`, or the best supported one below it; returns the level set
+SortNetworkLevel sort_network_select(SortNetworkLevel level) {
+    SortNetworkLevel best = sort_network_detect();
+    if (level > best)
+        level = best;
+    atomic_store_explicit(&sort_network_current, level, memory_order_relaxed);
+    return level;
+}
+
+const char *sort_network_name(SortNetworkLevel level) {
+    switch (level) {
+        case SORT_NETWORK_OFF: return "off";
+        case SORT_NETWORK_SCALAR: return "scalar";
+        case SORT_NETWORK_SSE41: return "sse4.1";
+        default: return "avx2";
+    }
+}
+
+int int_network_sort(int arr[], int n) {
+    SortNetworkLevel level = sort_network_level();
+
+    if (n > SORT_NETWORK_MAX || level == SORT_NETWORK_OFF)
+        return 0;
+    if (n < 2)
+        return 1;
+
+    switch (level) {
+#if SORT_NETWORK_X86
+        case SORT_NETWORK_AVX2:
+            avx2_sort(arr, n);
+            return 1;
+        case SORT_NETWORK_SSE41:
+            sse41_sort(arr, n);
+            return 1;
+#endif
+        case SORT_NETWORK_SCALAR:
+            scalar_sort(arr, n);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int int_network_merge(const int src[], int dst[], int left, int mid, int right) {
+    int na = mid - left + 1, nb = right - mid;
+
+    switch (sort_network_level()) {
+#if SORT_NETWORK_X86
+        case SORT_NETWORK_AVX2:
+            if (na < 8 || nb < 8)
+                return 0;
+            avx2_merge_runs(src + left, na, src + mid + 1, nb, dst + left);
+            return 1;
+        case SORT_NETWORK_SSE41:
+            if (na < 4 || nb < 4)
+                return 0;
+            sse41_merge_runs(src + left, na, src + mid + 1, nb, dst + left);
+            return 1;
+#endif
+        default:
+            return 0;   // The engine's scalar merge is as good as any
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef SORTING_NETWORK_H
+#define SORTING_NETWORK_H
+
+// Bitonic sorting networks for small int arrays, used as the leaves of the
+// quick and merge sort engines, plus a vectorized bitonic merge of two
+// sorted runs. The instruction set is picked at run time: AVX2 (8 lanes),
+// SSE4.1 (4 lanes) or a scalar network of branch-free min/max.
+
+#define SORT_NETWORK_MAX 32   // Largest array a network sorts
+
+typedef enum {
+    SORT_NETWORK_OFF,         // Kernels decline; engines use their own leaves
+    SORT_NETWORK_SCALAR,
+    SORT_NETWORK_SSE41,
+    SORT_NETWORK_AVX2
+} SortNetworkLevel;
+
+SortNetworkLevel sort_network_detect(void);
+SortNetworkLevel sort_network_level(void);
+SortNetworkLevel sort_network_select(SortNetworkLevel level);
+const char *sort_network_name(SortNetworkLevel level);
+
+// Sort arr[0..n-1] ascending if n <= SORT_NETWORK_MAX. Returns 1 if it did,
+// 0 (array untouched) if n is too large or the kernels are off.
+int int_network_sort(int arr[], int n);
+
+// Merge the sorted runs src[left..mid] and src[mid+1..right] into
+// dst[left..right]. Returns 0 without writing if no vector unit is selected
+// or a run is shorter than one vector.
+int int_network_merge(const int src[], int dst[], int left, int mid, int right);
+
+// For engine instances over other types: the network never applies
+#define no_network_sort(arr, n) 0
+#define no_network_merge(src, dst, left, mid, right) 0
+
+#endif